@@ -0,0 +1,52 @@
+// Prompt tokens spent per tuple by each TupleFormat, on a synthetic ticket-classification table.
+//
+//   cmake -DFLOCKMTL_BUILD_BENCHMARKS=ON ... && ./tuple_format_tokens [num_rows]
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+#include "flockmtl/model_manager/tiktoken.hpp"
+#include "flockmtl/prompt_manager/tuple_serializer.hpp"
+
+using namespace flockmtl;
+
+static nlohmann::json GenerateTickets(const int num_rows) {
+    const char* categories[] = {"billing", "shipping", "returns", "account", "technical"};
+    const char* statuses[] = {"open", "pending", "closed"};
+    auto tuples = nlohmann::json::array();
+    for (auto i = 0; i < num_rows; i++) {
+        nlohmann::json tuple;
+        tuple["ticket_id"] = 100000 + i;
+        tuple["amount"] = (i * 37 % 10000) / 100.0;
+        tuple["created_at"] = "2024-0" + std::to_string(1 + i % 9) + "-1" + std::to_string(i % 10);
+        tuple["escalated"] = i % 7 == 0;
+        tuple["category"] = categories[i % 5];
+        tuple["status"] = statuses[i % 3];
+        tuple["subject"] = "Order #" + std::to_string(5000 + i) + " arrived damaged, requesting a refund";
+        tuples.push_back(tuple);
+    }
+    return tuples;
+}
+
+int main(int argc, char** argv) {
+    const auto num_rows = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const auto tuples = GenerateTickets(num_rows);
+
+    std::cout << std::left << std::setw(18) << "format" << std::right << std::setw(14) << "total_tokens"
+              << std::setw(16) << "tokens_per_row" << std::setw(10) << "vs_md" << "\n";
+    double markdown_tokens = 0;
+    for (const auto format : {TupleFormat::MARKDOWN, TupleFormat::COMPACT_MARKDOWN, TupleFormat::CSV,
+                              TupleFormat::TSV, TupleFormat::JSONL, TupleFormat::COLUMNAR}) {
+        const auto tokens = static_cast<double>(Tiktoken::GetNumTokens(TupleSerializer::Serialize(tuples, format)));
+        if (format == TupleFormat::MARKDOWN) {
+            markdown_tokens = tokens;
+        }
+        std::cout << std::left << std::setw(18) << TupleSerializer::FormatName(format) << std::right
+                  << std::setw(14) << static_cast<long>(tokens) << std::setw(16) << std::fixed
+                  << std::setprecision(2) << tokens / num_rows << std::setw(10) << tokens / markdown_tokens
+                  << "\n";
+    }
+    return 0;
+}
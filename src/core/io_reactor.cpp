@@ -0,0 +1,54 @@
+#include "flockmtl/core/io_reactor.hpp"
+#include "flockmtl/core/config.hpp"
+
+namespace flockmtl {
+
+IoReactor& IoReactor::Get() {
+    static IoReactor reactor(Config::default_io_threads);
+    return reactor;
+}
+
+IoReactor::IoReactor(const int32_t num_threads) {
+    for (auto i = 0; i < num_threads; i++) {
+        threads_.emplace_back([this]() { Run(); });
+    }
+}
+
+IoReactor::~IoReactor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void IoReactor::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    condition_.notify_one();
+}
+
+void IoReactor::Run() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            // Queued tasks still run when stopping, their owners wait for them to finish
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        // Tasks report their own errors and must not throw
+        task();
+    }
+}
+
+} // namespace flockmtl
@@ -2,6 +2,8 @@
 
 #include "flockmtl/core/common.hpp"
 #include "flockmtl/core/config.hpp"
+#include "flockmtl/prompt_manager/tuple_serializer.hpp"
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
 
@@ -29,6 +31,42 @@ void ModelParser::Parse(const std::string& query, std::unique_ptr<QueryStatement
     }
 }
 
+void ModelParser::ValidateModelArgs(const nlohmann::json& model_args) {
+    const std::set<std::string> required_keys = {"context_window", "max_output_tokens"};
+    const std::set<std::string> optional_keys = {"connect_timeout", "request_timeout", "tuple_format", "cascade",
+                                                 "cascade_threshold"};
+    std::set<std::string> json_keys;
+    for (auto it = model_args.begin(); it != model_args.end(); ++it) {
+        if (required_keys.count(it.key()) == 0 && optional_keys.count(it.key()) == 0) {
+            throw std::runtime_error(duckdb_fmt::format("Unexpected key in model_args: {}.", it.key()));
+        }
+        json_keys.insert(it.key());
+    }
+    for (const auto& key : required_keys) {
+        if (json_keys.count(key) == 0) {
+            throw std::runtime_error("Expected keys: context_window, max_output_tokens in model_args.");
+        }
+    }
+    if (model_args.contains("tuple_format")) {
+        TupleSerializer::ParseFormat(model_args["tuple_format"].get<std::string>());
+    }
+    if (model_args.contains("cascade")) {
+        const auto& cascade = model_args["cascade"];
+        if (!cascade.is_array() || cascade.empty() ||
+            !std::all_of(cascade.begin(), cascade.end(), [](const nlohmann::json& model_name) {
+                return model_name.is_string() && !model_name.get<std::string>().empty();
+            })) {
+            throw std::runtime_error("Expected cascade to be a non-empty list of model names in model_args.");
+        }
+    }
+    if (model_args.contains("cascade_threshold")) {
+        const auto& threshold = model_args["cascade_threshold"];
+        if (!threshold.is_number() || threshold.get<double>() < 0 || threshold.get<double>() > 1) {
+            throw std::runtime_error("Expected cascade_threshold to be a number between 0 and 1 in model_args.");
+        }
+    }
+}
+
 void ModelParser::ParseCreateModel(Tokenizer& tokenizer, std::unique_ptr<QueryStatement>& statement) {
     auto token = tokenizer.NextToken();
     auto value = duckdb::StringUtil::Upper(token.value);
@@ -89,14 +127,7 @@ void ModelParser::ParseCreateModel(Tokenizer& tokenizer, std::unique_ptr<QuerySt
         throw std::runtime_error("Expected json value for the model_args.");
     }
     auto model_args = nlohmann::json::parse(token.value);
-    const std::set<std::string> expected_keys = {"context_window", "max_output_tokens"};
-    std::set<std::string> json_keys;
-    for (auto it = model_args.begin(); it != model_args.end(); ++it) {
-        json_keys.insert(it.key());
-    }
-    if (json_keys != expected_keys) {
-        throw std::runtime_error("Expected keys: context_window, max_output_tokens in model_args.");
-    }
+    ValidateModelArgs(model_args);
 
     token = tokenizer.NextToken();
     if (token.type != TokenType::PARENTHESIS || token.value != ")") {
@@ -216,14 +247,7 @@ void ModelParser::ParseUpdateModel(Tokenizer& tokenizer, std::unique_ptr<QuerySt
             throw std::runtime_error("Expected json value for the model_args.");
         }
         auto new_model_args = nlohmann::json::parse(token.value);
-        const std::set<std::string> expected_keys = {"context_window", "max_output_tokens"};
-        std::set<std::string> json_keys;
-        for (auto it = new_model_args.begin(); it != new_model_args.end(); ++it) {
-            json_keys.insert(it.key());
-        }
-        if (json_keys != expected_keys) {
-            throw std::runtime_error("Expected keys: context_window, max_output_tokens in model_args.");
-        }
+        ValidateModelArgs(new_model_args);
 
         token = tokenizer.NextToken();
         if (token.type != TokenType::PARENTHESIS || token.value != ")") {
@@ -7,11 +7,17 @@
 #include "flockmtl/core/common.hpp"
 #include "flockmtl/core/config.hpp"
 #include "flockmtl/custom_parser/query_parser.hpp"
+#include "flockmtl/model_manager/embedding_cache.hpp"
+#include "flockmtl/optimizer/llm_optimizer.hpp"
 
 #include <flockmtl/model_manager/model.hpp>
 
 namespace duckdb {
 
+static void SetEmbeddingCacheSize(ClientContext& context, SetScope scope, Value& parameter) {
+    flockmtl::EmbeddingCache::Get().SetCapacity(DBConfig::ParseMemoryLimit(parameter.ToString()));
+}
+
 static void LoadInternal(DatabaseInstance& instance) {
     flockmtl::Config::Configure(instance);
 
@@ -20,6 +26,45 @@ static void LoadInternal(DatabaseInstance& instance) {
     DuckParserExtension duck_parser;
     config.parser_extensions.push_back(duck_parser);
     config.operator_extensions.push_back(make_uniq<DuckOperatorExtension>());
+
+    // Move LLM projections off the worker threads
+    config.optimizer_extensions.push_back(flockmtl::LlmOptimizerExtension());
+    config.AddExtensionOption("flockmtl_async_llm_operator",
+                              "Evaluate LLM function projections on FlockMTL's I/O threads instead of blocking DuckDB "
+                              "worker threads",
+                              LogicalType::BOOLEAN, Value::BOOLEAN(true));
+    config.AddExtensionOption("flockmtl_filter_ids",
+                              "Have llm_filter return only the ids of the matching tuples instead of one boolean per "
+                              "tuple",
+                              LogicalType::BOOLEAN, Value::BOOLEAN(true));
+    config.AddExtensionOption("flockmtl_prefilter_model",
+                              "Embedding model used to drop the rows an llm_filter prompt is irrelevant to before they "
+                              "reach the model, empty to send every row",
+                              LogicalType::VARCHAR, Value(""));
+    config.AddExtensionOption("flockmtl_prefilter_recall",
+                              "Share of the sampled llm_filter matches the embedding pre-filter cutoff must keep",
+                              LogicalType::DOUBLE, Value::DOUBLE(flockmtl::Config::default_prefilter_recall));
+    config.AddExtensionOption("flockmtl_rerank_embedding_model",
+                              "Embedding model used to keep only the candidates closest to the prompt before "
+                              "llm_rerank's window passes, empty to rerank every candidate",
+                              LogicalType::VARCHAR, Value(""));
+    config.AddExtensionOption("flockmtl_rerank_candidates",
+                              "Candidates llm_rerank keeps after embedding pruning, 0 to keep all of them",
+                              LogicalType::BIGINT, Value::BIGINT(flockmtl::Config::default_rerank_candidates));
+    config.AddExtensionOption("flockmtl_join_embedding_model",
+                              "Embedding model used to block the candidate pairs of joins on llm_filter, empty to "
+                              "evaluate every pair",
+                              LogicalType::VARCHAR, Value(""));
+    config.AddExtensionOption("flockmtl_join_top_k",
+                              "Right rows each left row is paired with by the embedding blocking of joins on "
+                              "llm_filter",
+                              LogicalType::BIGINT, Value::BIGINT(flockmtl::Config::default_join_top_k));
+    config.AddExtensionOption("flockmtl_embedding_cache_size",
+                              "Memory the embeddings cached across queries may take, e.g. '256MB', the oldest are "
+                              "evicted first",
+                              LogicalType::VARCHAR, Value("256MB"), SetEmbeddingCacheSize);
+    config.AddExtensionOption("flockmtl_cluster_embedding_model", "Embedding model llm_cluster groups the rows with",
+                              LogicalType::VARCHAR, Value("text-embedding-3-small"));
 }
 
 ParserExtensionParseResult duck_parse(ParserExtensionInfo*, const std::string& query) {
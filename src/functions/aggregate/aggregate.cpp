@@ -18,6 +18,18 @@ void AggregateFunctionBase::ValidateArguments(duckdb::Vector inputs[], idx_t inp
     }
 }
 
+duckdb::unique_ptr<duckdb::FunctionData>
+AggregateFunctionBase::Bind(duckdb::ClientContext& context, duckdb::AggregateFunction& function,
+                            duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments) {
+    return duckdb::make_uniq<AggregateFunctionBindData>(context);
+}
+
+void AggregateFunctionBase::SetInterruptFlag(Model& model, const duckdb::AggregateInputData& aggr_input_data) {
+    if (aggr_input_data.bind_data) {
+        model.SetInterruptFlag(aggr_input_data.bind_data->Cast<AggregateFunctionBindData>().context.interrupted);
+    }
+}
+
 std::tuple<nlohmann::json, nlohmann::json, std::vector<nlohmann::json>>
 AggregateFunctionBase::CastInputsToJson(duckdb::Vector inputs[], idx_t count) {
     auto model_details_json = CastVectorOfStructsToJson(inputs[0], 1)[0];
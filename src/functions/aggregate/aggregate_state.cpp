@@ -1,15 +1,62 @@
-#include "flockmtl/functions/aggregate/aggregate.hpp"
+#include "flockmtl/functions/aggregate/aggregate_state.hpp"
+
+#include <algorithm>
+#include <atomic>
 
 namespace flockmtl {
 
+SampleRandom::result_type SampleRandom::operator()() {
+    if (state == 0) {
+        static std::atomic<uint64_t> seeds {0};
+        state = (seeds.fetch_add(1) + 1) * 0x9E3779B97F4A7C15ULL;
+    }
+    auto z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
 void AggregateFunctionState::Initialize() {}
 
-void AggregateFunctionState::Update(const nlohmann::json& input) { value.push_back(input); }
+void AggregateFunctionState::Update(const nlohmann::json& input) {
+    seen++;
+    if (sample_size == 0 || value.size() < sample_size) {
+        value.push_back(input);
+        return;
+    }
+    // Reservoir sampling: every tuple seen so far is kept with the same probability
+    const auto slot = random.Below(seen);
+    if (slot < sample_size) {
+        value[slot] = input;
+    }
+}
 
 void AggregateFunctionState::Combine(const AggregateFunctionState& source) {
-    for (auto& input : source.value) {
-        Update(std::move(input));
+    // Combine targets are fresh states, they take the sample size of what they receive
+    sample_size = std::max(sample_size, source.sample_size);
+    if (sample_size == 0 || value.size() + source.value.size() <= sample_size) {
+        value.insert(value.end(), source.value.begin(), source.value.end());
+        seen += source.seen;
+        return;
+    }
+
+    // Both samples are uniform over their own tuples, so drawing from each in proportion to the tuples it has not
+    // yet given keeps the merged sample uniform over all of them
+    auto lhs = std::move(value);
+    auto rhs = source.value;
+    std::shuffle(lhs.begin(), lhs.end(), random);
+    std::shuffle(rhs.begin(), rhs.end(), random);
+    auto lhs_left = seen;
+    auto rhs_left = source.seen;
+    value.clear();
+    while (value.size() < sample_size && (!lhs.empty() || !rhs.empty())) {
+        const auto from_lhs = rhs.empty() || (!lhs.empty() && random.Below(lhs_left + rhs_left) < lhs_left);
+        auto& side = from_lhs ? lhs : rhs;
+        value.push_back(std::move(side.back()));
+        side.pop_back();
+        (from_lhs ? lhs_left : rhs_left)--;
     }
+    seen += source.seen;
 }
 
 } // namespace flockmtl
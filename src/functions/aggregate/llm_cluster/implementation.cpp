@@ -0,0 +1,216 @@
+#include "flockmtl/functions/aggregate/llm_cluster.hpp"
+#include "flockmtl/model_manager/embedding_cache.hpp"
+
+#include "duckdb/execution/expression_executor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+
+namespace flockmtl {
+
+duckdb::unique_ptr<duckdb::FunctionData>
+LlmCluster::Bind(duckdb::ClientContext& context, duckdb::AggregateFunction& function,
+                 duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments) {
+    auto num_clusters = static_cast<idx_t>(Config::default_cluster_count);
+    if (arguments.size() == 4) {
+        if (!arguments[3]->IsFoldable()) {
+            throw std::runtime_error("The number of clusters must be a constant.");
+        }
+        auto value = duckdb::ExpressionExecutor::EvaluateScalar(context, *arguments[3]);
+        if (value.IsNull() || value.GetValue<int64_t>() < 1) {
+            throw std::runtime_error("The number of clusters must be at least 1.");
+        }
+        num_clusters = static_cast<idx_t>(value.GetValue<int64_t>());
+    }
+    return duckdb::make_uniq<LlmClusterBindData>(context, num_clusters);
+}
+
+std::vector<idx_t> LlmCluster::KMeans(const std::vector<float>& embeddings, const idx_t dimensions,
+                                      const idx_t num_clusters, std::vector<float>& centroids) {
+    const auto num_points = embeddings.size() / dimensions;
+    auto point = [&](const idx_t i) { return embeddings.data() + i * dimensions; };
+    auto distance = [&](const float* lhs, const float* rhs) {
+        float sum = 0;
+        for (idx_t d = 0; d < dimensions; d++) {
+            const auto diff = lhs[d] - rhs[d];
+            sum += diff * diff;
+        }
+        return sum;
+    };
+    auto nearest = [&](const float* embedding) {
+        idx_t best = 0;
+        auto best_distance = std::numeric_limits<float>::max();
+        for (idx_t c = 0; c < num_clusters; c++) {
+            const auto candidate = distance(embedding, centroids.data() + c * dimensions);
+            if (candidate < best_distance) {
+                best = c;
+                best_distance = candidate;
+            }
+        }
+        return best;
+    };
+
+    // k-means++ seeding, with a fixed seed so the same rows give the same clusters
+    std::mt19937 random(42);
+    centroids.clear();
+    auto first = std::uniform_int_distribution<idx_t>(0, num_points - 1)(random);
+    centroids.insert(centroids.end(), point(first), point(first) + dimensions);
+    std::vector<float> closest(num_points, std::numeric_limits<float>::max());
+    for (idx_t c = 1; c < num_clusters; c++) {
+        const auto* last = centroids.data() + (c - 1) * dimensions;
+        double total = 0;
+        for (idx_t i = 0; i < num_points; i++) {
+            closest[i] = std::min(closest[i], distance(point(i), last));
+            total += closest[i];
+        }
+        auto target = std::uniform_real_distribution<double>(0, total)(random);
+        idx_t chosen = 0;
+        for (; chosen + 1 < num_points; chosen++) {
+            target -= closest[chosen];
+            if (target <= 0) {
+                break;
+            }
+        }
+        centroids.insert(centroids.end(), point(chosen), point(chosen) + dimensions);
+    }
+
+    // Mini-batch updates: each sampled point pulls its centroid by the inverse of the points it has seen
+    const auto batch_size = std::min(num_points, static_cast<idx_t>(Config::default_cluster_batch_size));
+    std::uniform_int_distribution<idx_t> sample(0, num_points - 1);
+    std::vector<idx_t> seen(num_clusters, 0);
+    std::vector<idx_t> batch(batch_size);
+    std::vector<idx_t> batch_clusters(batch_size);
+    for (int32_t iteration = 0; iteration < Config::default_cluster_iterations; iteration++) {
+        for (idx_t b = 0; b < batch_size; b++) {
+            batch[b] = sample(random);
+            batch_clusters[b] = nearest(point(batch[b]));
+        }
+        for (idx_t b = 0; b < batch_size; b++) {
+            const auto cluster = batch_clusters[b];
+            const auto rate = 1.0f / static_cast<float>(++seen[cluster]);
+            auto* centroid = centroids.data() + cluster * dimensions;
+            const auto* embedding = point(batch[b]);
+            for (idx_t d = 0; d < dimensions; d++) {
+                centroid[d] += rate * (embedding[d] - centroid[d]);
+            }
+        }
+    }
+
+    std::vector<idx_t> assignments(num_points);
+    for (idx_t i = 0; i < num_points; i++) {
+        assignments[i] = nearest(point(i));
+    }
+    return assignments;
+}
+
+nlohmann::json LlmCluster::LabelCluster(const std::vector<nlohmann::json>& representatives) {
+    auto tuples = nlohmann::json::array();
+    for (const auto& representative : representatives) {
+        tuples.push_back(representative);
+    }
+    auto prompt =
+        PromptManager::Render(user_query, tuples, AggregateFunctionType::REDUCE, model.GetModelDetails().tuple_format);
+    auto response = model.CallComplete(prompt);
+    return response["output"];
+}
+
+nlohmann::json LlmCluster::Cluster(duckdb::ClientContext& context, const std::vector<nlohmann::json>& tuples,
+                                   const idx_t num_clusters) {
+    auto clusters = nlohmann::json::array();
+    if (tuples.empty()) {
+        return clusters;
+    }
+
+    duckdb::Value embedding_model_name;
+    if (!context.TryGetCurrentSetting("flockmtl_cluster_embedding_model", embedding_model_name) ||
+        embedding_model_name.IsNull() || embedding_model_name.ToString().empty()) {
+        throw std::runtime_error("llm_cluster needs an embedding model in flockmtl_cluster_embedding_model.");
+    }
+    Model embedding_model(nlohmann::json {{"model_name", embedding_model_name.ToString()}});
+    embedding_model.SetInterruptFlag(context.interrupted);
+    std::vector<std::string> texts;
+    texts.reserve(tuples.size());
+    for (const auto& tuple : tuples) {
+        texts.push_back(EmbeddingCache::TupleText(tuple));
+    }
+    const auto embeddings = EmbeddingCache::Get().Embed(embedding_model, texts);
+
+    // Unit length, so the euclidean distances of k-means follow the cosine similarities
+    const auto dimensions = embeddings[0].size();
+    std::vector<float> normalized;
+    normalized.reserve(embeddings.size() * dimensions);
+    for (const auto& embedding : embeddings) {
+        if (embedding.size() != dimensions) {
+            throw std::runtime_error("The embedding model returned embeddings of different sizes.");
+        }
+        const auto norm = std::sqrt(std::inner_product(embedding.begin(), embedding.end(), embedding.begin(), 0.0));
+        for (const auto value : embedding) {
+            normalized.push_back(static_cast<float>(norm > 0 ? value / norm : 0));
+        }
+    }
+
+    std::vector<float> centroids;
+    const auto assignments = KMeans(normalized, dimensions, std::min<idx_t>(num_clusters, tuples.size()), centroids);
+    std::vector<std::vector<idx_t>> members(centroids.size() / dimensions);
+    for (idx_t i = 0; i < assignments.size(); i++) {
+        members[assignments[i]].push_back(i);
+    }
+    std::sort(members.begin(), members.end(),
+              [](const std::vector<idx_t>& lhs, const std::vector<idx_t>& rhs) { return lhs.size() > rhs.size(); });
+
+    for (auto& cluster : members) {
+        if (cluster.empty()) {
+            continue;
+        }
+        // Named from the tuples closest to the centroid, one model call per cluster
+        std::vector<float> centroid(dimensions, 0);
+        for (const auto i : cluster) {
+            for (idx_t d = 0; d < dimensions; d++) {
+                centroid[d] += normalized[i * dimensions + d];
+            }
+        }
+        std::vector<std::pair<float, idx_t>> ranked;
+        for (const auto i : cluster) {
+            const auto similarity =
+                std::inner_product(centroid.begin(), centroid.end(), normalized.begin() + i * dimensions, 0.0f);
+            ranked.emplace_back(-similarity, i);
+        }
+        const auto num_representatives =
+            std::min<size_t>(ranked.size(), static_cast<size_t>(Config::default_cluster_representatives));
+        std::partial_sort(ranked.begin(), ranked.begin() + num_representatives, ranked.end());
+        std::vector<nlohmann::json> representatives;
+        for (size_t r = 0; r < num_representatives; r++) {
+            representatives.push_back(tuples[ranked[r].second]);
+        }
+
+        auto cluster_tuples = nlohmann::json::array();
+        for (const auto i : cluster) {
+            cluster_tuples.push_back(tuples[i]);
+        }
+        clusters.push_back({{"label", LabelCluster(representatives)},
+                            {"size", cluster.size()},
+                            {"tuples", std::move(cluster_tuples)}});
+    }
+    return clusters;
+}
+
+void LlmCluster::Finalize(duckdb::Vector& states, duckdb::AggregateInputData& aggr_input_data, duckdb::Vector& result,
+                          idx_t count, idx_t offset) {
+    auto states_vector = duckdb::FlatVector::GetData<AggregateFunctionState*>(states);
+    auto function_instance = AggregateFunctionBase::GetInstance<LlmCluster>();
+    SetInterruptFlag(function_instance->model, aggr_input_data);
+    auto& bind_data = aggr_input_data.bind_data->Cast<LlmClusterBindData>();
+    for (idx_t i = 0; i < count; i++) {
+        auto idx = i + offset;
+        auto state_ptr = states_vector[idx];
+        auto state = function_instance->state_map[state_ptr];
+
+        auto clusters = function_instance->Cluster(bind_data.context, state->value, bind_data.num_clusters);
+        result.SetValue(idx, clusters.dump());
+    }
+}
+
+} // namespace flockmtl
@@ -0,0 +1,14 @@
+#include "flockmtl/functions/aggregate/llm_cluster.hpp"
+
+namespace flockmtl {
+
+template void AggregateFunctionBase::Initialize<LlmCluster>(const duckdb::AggregateFunction& function,
+                                                            duckdb::data_ptr_t state_p);
+template void AggregateFunctionBase::Operation<LlmCluster>(duckdb::Vector[], duckdb::AggregateInputData&, idx_t,
+                                                           duckdb::Vector&, idx_t);
+template void AggregateFunctionBase::SimpleUpdate<LlmCluster>(duckdb::Vector[], duckdb::AggregateInputData&, idx_t,
+                                                              duckdb::data_ptr_t, idx_t);
+template void AggregateFunctionBase::Combine<LlmCluster>(duckdb::Vector&, duckdb::Vector&, duckdb::AggregateInputData&,
+                                                         idx_t);
+
+} // namespace flockmtl
@@ -0,0 +1,23 @@
+#include "flockmtl/functions/aggregate/llm_cluster.hpp"
+#include "flockmtl/registry/registry.hpp"
+
+namespace flockmtl {
+
+void AggregateRegistry::RegisterLlmCluster(duckdb::DatabaseInstance& db) {
+    duckdb::AggregateFunctionSet llm_cluster("llm_cluster");
+    duckdb::vector<duckdb::LogicalType> arguments = {duckdb::LogicalType::ANY, duckdb::LogicalType::ANY,
+                                                     duckdb::LogicalType::ANY};
+    for (auto with_num_clusters : {false, true}) {
+        if (with_num_clusters) {
+            arguments.push_back(duckdb::LogicalType::BIGINT);
+        }
+        llm_cluster.AddFunction(duckdb::AggregateFunction(
+            arguments, duckdb::LogicalType::VARCHAR, duckdb::AggregateFunction::StateSize<AggregateFunctionState>,
+            LlmCluster::Initialize, LlmCluster::Operation, LlmCluster::Combine, LlmCluster::Finalize,
+            LlmCluster::SimpleUpdate, LlmCluster::Bind));
+    }
+
+    duckdb::ExtensionUtil::RegisterFunction(db, llm_cluster);
+}
+
+} // namespace flockmtl
@@ -5,7 +5,7 @@ namespace flockmtl {
 int LlmFirstOrLast::GetAvailableTokens() {
     int num_tokens_meta_and_user_query = 0;
     num_tokens_meta_and_user_query += Tiktoken::GetNumTokens(user_query);
-    num_tokens_meta_and_user_query += Tiktoken::GetNumTokens(PromptManager::GetTemplate(function_type));
+    num_tokens_meta_and_user_query += PromptManager::GetStaticTokens(function_type);
 
     auto model_context_size = model.GetModelDetails().context_window;
     if (num_tokens_meta_and_user_query > model_context_size) {
@@ -18,30 +18,29 @@ int LlmFirstOrLast::GetAvailableTokens() {
 
 int LlmFirstOrLast::GetFirstOrLastTupleId(const nlohmann::json& tuples) {
     nlohmann::json data;
-    auto prompt = PromptManager::Render(user_query, tuples, function_type);
+    auto prompt = PromptManager::Render(user_query, tuples, function_type, model.GetModelDetails().tuple_format);
     auto response = model.CallComplete(prompt);
     return response["selected"].get<int>();
 }
 
 nlohmann::json LlmFirstOrLast::Evaluate(nlohmann::json& tuples) {
     auto available_tokens = GetAvailableTokens();
+    BatchTokenCounter batch_tokens(model.GetModelDetails().tuple_format);
     auto accumulated_tuples_tokens = 0u;
     auto batch_tuples = nlohmann::json::array();
     int start_index = 0;
 
     do {
         accumulated_tuples_tokens = Tiktoken::GetNumTokens(batch_tuples.dump());
-        accumulated_tuples_tokens +=
-            Tiktoken::GetNumTokens(PromptManager::ConstructMarkdownHeader(tuples[start_index]));
-        while (accumulated_tuples_tokens < static_cast<unsigned int>(available_tokens) &&
+        batch_tokens.Clear();
+        while (accumulated_tuples_tokens + batch_tokens.Tokens() < static_cast<unsigned int>(available_tokens) &&
                start_index < static_cast<int>(tuples.size())) {
-            const auto num_tokens =
-                Tiktoken::GetNumTokens(PromptManager::ConstructMarkdownSingleTuple(tuples[start_index]));
-            if (accumulated_tuples_tokens + num_tokens > static_cast<unsigned int>(available_tokens)) {
+            const auto measurement = batch_tokens.Measure(tuples[start_index]);
+            if (accumulated_tuples_tokens + measurement.tokens > static_cast<unsigned int>(available_tokens)) {
                 break;
             }
             batch_tuples.push_back(tuples[start_index]);
-            accumulated_tuples_tokens += num_tokens;
+            batch_tokens.Add(tuples[start_index], measurement);
             start_index++;
         }
         auto result_idx = GetFirstOrLastTupleId(batch_tuples);
@@ -58,6 +57,7 @@ void LlmFirstOrLast::FinalizeResults(duckdb::Vector& states, duckdb::AggregateIn
                                      AggregateFunctionType function_type) {
     auto states_vector = duckdb::FlatVector::GetData<AggregateFunctionState*>(states);
     auto function_instance = AggregateFunctionBase::GetInstance<LlmFirstOrLast>();
+    SetInterruptFlag(function_instance->model, aggr_input_data);
     function_instance->function_type = function_type;
     for (idx_t i = 0; i < count; i++) {
         auto idx = i + offset;
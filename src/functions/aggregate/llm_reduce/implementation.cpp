@@ -1,11 +1,13 @@
 #include "flockmtl/functions/aggregate/llm_reduce.hpp"
 
+#include "duckdb/execution/expression_executor.hpp"
+
 namespace flockmtl {
 
 int LlmReduce::GetAvailableTokens(const AggregateFunctionType& function_type) {
     int num_tokens_meta_and_reduce_query = 0;
     num_tokens_meta_and_reduce_query += Tiktoken::GetNumTokens(user_query);
-    num_tokens_meta_and_reduce_query += Tiktoken::GetNumTokens(PromptManager::GetTemplate(function_type));
+    num_tokens_meta_and_reduce_query += PromptManager::GetStaticTokens(function_type);
 
     auto model_context_size = model.GetModelDetails().context_window;
     if (num_tokens_meta_and_reduce_query > model_context_size) {
@@ -18,7 +20,7 @@ int LlmReduce::GetAvailableTokens(const AggregateFunctionType& function_type) {
 
 nlohmann::json LlmReduce::ReduceBatch(const nlohmann::json& tuples, const AggregateFunctionType& function_type) {
     nlohmann::json data;
-    auto prompt = PromptManager::Render(user_query, tuples, function_type);
+    auto prompt = PromptManager::Render(user_query, tuples, function_type, model.GetModelDetails().tuple_format);
     auto response = model.CallComplete(prompt);
     return response["output"];
 };
@@ -26,23 +28,22 @@ nlohmann::json LlmReduce::ReduceBatch(const nlohmann::json& tuples, const Aggreg
 nlohmann::json LlmReduce::ReduceLoop(const std::vector<nlohmann::json>& tuples,
                                      const AggregateFunctionType& function_type) {
     auto available_tokens = GetAvailableTokens(function_type);
+    BatchTokenCounter batch_tokens(model.GetModelDetails().tuple_format);
     auto accumulated_tuples_tokens = 0u;
     auto batch_tuples = nlohmann::json::array();
     int start_index = 0;
 
     do {
         accumulated_tuples_tokens = Tiktoken::GetNumTokens(batch_tuples.dump());
-        accumulated_tuples_tokens +=
-            Tiktoken::GetNumTokens(PromptManager::ConstructMarkdownHeader(tuples[start_index]));
-        while (accumulated_tuples_tokens < static_cast<unsigned int>(available_tokens) &&
+        batch_tokens.Clear();
+        while (accumulated_tuples_tokens + batch_tokens.Tokens() < static_cast<unsigned int>(available_tokens) &&
                start_index < static_cast<int>(tuples.size())) {
-            const auto num_tokens =
-                Tiktoken::GetNumTokens(PromptManager::ConstructMarkdownSingleTuple(tuples[start_index]));
-            if (accumulated_tuples_tokens + num_tokens > static_cast<unsigned int>(available_tokens)) {
+            const auto measurement = batch_tokens.Measure(tuples[start_index]);
+            if (accumulated_tuples_tokens + measurement.tokens > static_cast<unsigned int>(available_tokens)) {
                 break;
             }
             batch_tuples.push_back(tuples[start_index]);
-            accumulated_tuples_tokens += num_tokens;
+            batch_tokens.Add(tuples[start_index], measurement);
             start_index++;
         }
         auto response = ReduceBatch(batch_tuples, function_type);
@@ -54,18 +55,51 @@ nlohmann::json LlmReduce::ReduceLoop(const std::vector<nlohmann::json>& tuples,
     return batch_tuples[0];
 }
 
+duckdb::unique_ptr<duckdb::FunctionData>
+LlmReduce::Bind(duckdb::ClientContext& context, duckdb::AggregateFunction& function,
+                duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments) {
+    idx_t sample_size = 0;
+    if (arguments.size() == 4) {
+        if (!arguments[3]->IsFoldable()) {
+            throw std::runtime_error("The sample size must be a constant.");
+        }
+        auto value = duckdb::ExpressionExecutor::EvaluateScalar(context, *arguments[3]);
+        if (value.IsNull() || value.GetValue<int64_t>() < 1) {
+            throw std::runtime_error("The sample size must be at least 1.");
+        }
+        sample_size = static_cast<idx_t>(value.GetValue<int64_t>());
+    }
+    return duckdb::make_uniq<LlmReduceBindData>(context, sample_size);
+}
+
+idx_t LlmReduce::SampleSize(const duckdb::AggregateInputData& aggr_input_data) {
+    if (!aggr_input_data.bind_data) {
+        return 0;
+    }
+    return aggr_input_data.bind_data->Cast<LlmReduceBindData>().sample_size;
+}
+
 void LlmReduce::FinalizeResults(duckdb::Vector& states, duckdb::AggregateInputData& aggr_input_data,
                                 duckdb::Vector& result, idx_t count, idx_t offset,
                                 const AggregateFunctionType function_type) {
     auto states_vector = duckdb::FlatVector::GetData<AggregateFunctionState*>(states);
 
     auto function_instance = AggregateFunctionBase::GetInstance<LlmReduce>();
+    SetInterruptFlag(function_instance->model, aggr_input_data);
     for (idx_t i = 0; i < count; i++) {
         auto idx = i + offset;
         auto state_ptr = states_vector[idx];
         auto state = function_instance->state_map[state_ptr];
 
         auto response = function_instance->ReduceLoop(state->value, function_type);
+        if (state->sample_size > 0) {
+            // Approximate mode, the result says how much of the group it was computed from
+            response = {{"output", std::move(response)},
+                        {"sampled_rows", state->value.size()},
+                        {"total_rows", state->seen},
+                        {"sample_fraction",
+                         state->seen > 0 ? static_cast<double>(state->value.size()) / state->seen : 1.0}};
+        }
         result.SetValue(idx, response.dump());
     }
 }
@@ -4,23 +4,37 @@
 namespace flockmtl {
 
 void AggregateRegistry::RegisterLlmReduce(duckdb::DatabaseInstance& db) {
-    auto string_concat = duckdb::AggregateFunction(
-        "llm_reduce", {duckdb::LogicalType::ANY, duckdb::LogicalType::ANY, duckdb::LogicalType::ANY},
-        duckdb::LogicalType::VARCHAR, duckdb::AggregateFunction::StateSize<AggregateFunctionState>,
-        LlmReduce::Initialize, LlmReduce::Operation, LlmReduce::Combine,
-        LlmReduce::Finalize<AggregateFunctionType::REDUCE>, LlmReduce::SimpleUpdate);
+    duckdb::AggregateFunctionSet llm_reduce("llm_reduce");
+    duckdb::vector<duckdb::LogicalType> arguments = {duckdb::LogicalType::ANY, duckdb::LogicalType::ANY,
+                                                     duckdb::LogicalType::ANY};
+    for (auto with_sample_size : {false, true}) {
+        if (with_sample_size) {
+            arguments.push_back(duckdb::LogicalType::BIGINT);
+        }
+        llm_reduce.AddFunction(duckdb::AggregateFunction(
+            arguments, duckdb::LogicalType::VARCHAR, duckdb::AggregateFunction::StateSize<AggregateFunctionState>,
+            LlmReduce::Initialize, LlmReduce::Operation, LlmReduce::Combine,
+            LlmReduce::Finalize<AggregateFunctionType::REDUCE>, LlmReduce::SimpleUpdate, LlmReduce::Bind));
+    }
 
-    duckdb::ExtensionUtil::RegisterFunction(db, string_concat);
+    duckdb::ExtensionUtil::RegisterFunction(db, llm_reduce);
 }
 
 void AggregateRegistry::RegisterLlmReduceJson(duckdb::DatabaseInstance& db) {
-    auto string_concat = duckdb::AggregateFunction(
-        "llm_reduce_json", {duckdb::LogicalType::ANY, duckdb::LogicalType::ANY, duckdb::LogicalType::ANY},
-        duckdb::LogicalType::VARCHAR, duckdb::AggregateFunction::StateSize<AggregateFunctionState>,
-        LlmReduce::Initialize, LlmReduce::Operation, LlmReduce::Combine,
-        LlmReduce::Finalize<AggregateFunctionType::REDUCE_JSON>, LlmReduce::SimpleUpdate);
+    duckdb::AggregateFunctionSet llm_reduce_json("llm_reduce_json");
+    duckdb::vector<duckdb::LogicalType> arguments = {duckdb::LogicalType::ANY, duckdb::LogicalType::ANY,
+                                                     duckdb::LogicalType::ANY};
+    for (auto with_sample_size : {false, true}) {
+        if (with_sample_size) {
+            arguments.push_back(duckdb::LogicalType::BIGINT);
+        }
+        llm_reduce_json.AddFunction(duckdb::AggregateFunction(
+            arguments, duckdb::LogicalType::VARCHAR, duckdb::AggregateFunction::StateSize<AggregateFunctionState>,
+            LlmReduce::Initialize, LlmReduce::Operation, LlmReduce::Combine,
+            LlmReduce::Finalize<AggregateFunctionType::REDUCE_JSON>, LlmReduce::SimpleUpdate, LlmReduce::Bind));
+    }
 
-    duckdb::ExtensionUtil::RegisterFunction(db, string_concat);
+    duckdb::ExtensionUtil::RegisterFunction(db, llm_reduce_json);
 }
 
-} // namespace flockmtl
\ No newline at end of file
+} // namespace flockmtl
@@ -1,4 +1,8 @@
 #include "flockmtl/functions/aggregate/llm_rerank.hpp"
+#include "flockmtl/model_manager/embedding_cache.hpp"
+
+#include <algorithm>
+#include <numeric>
 
 namespace flockmtl {
 
@@ -6,7 +10,7 @@ int LlmRerank::GetAvailableTokens() {
     int num_tokens_meta_and_reduce_query = 0;
     num_tokens_meta_and_reduce_query += Tiktoken::GetNumTokens(user_query);
     num_tokens_meta_and_reduce_query +=
-        Tiktoken::GetNumTokens(PromptManager::GetTemplate(AggregateFunctionType::RERANK));
+        PromptManager::GetStaticTokens(AggregateFunctionType::RERANK);
 
     auto model_context_size = model.GetModelDetails().context_window;
     if (num_tokens_meta_and_reduce_query > model_context_size) {
@@ -17,9 +21,45 @@ int LlmRerank::GetAvailableTokens() {
     return available_tokens;
 }
 
+nlohmann::json LlmRerank::PruneCandidates(duckdb::ClientContext& context, const nlohmann::json& tuples) {
+    duckdb::Value embedding_model_name;
+    if (!context.TryGetCurrentSetting("flockmtl_rerank_embedding_model", embedding_model_name) ||
+        embedding_model_name.IsNull() || embedding_model_name.ToString().empty()) {
+        return tuples;
+    }
+    duckdb::Value candidates_value;
+    auto num_candidates = static_cast<size_t>(Config::default_rerank_candidates);
+    if (context.TryGetCurrentSetting("flockmtl_rerank_candidates", candidates_value) && !candidates_value.IsNull()) {
+        num_candidates = static_cast<size_t>(std::max<int64_t>(candidates_value.GetValue<int64_t>(), 0));
+    }
+    if (num_candidates == 0 || tuples.size() <= num_candidates) {
+        return tuples;
+    }
+
+    Model embedding_model(nlohmann::json {{"model_name", embedding_model_name.ToString()}});
+    embedding_model.SetInterruptFlag(context.interrupted);
+    const std::vector<nlohmann::json> rows(tuples.begin(), tuples.end());
+    const auto similarities = EmbeddingCache::Get().Similarities(embedding_model, user_query, rows);
+
+    std::vector<size_t> order(rows.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::nth_element(order.begin(), order.begin() + num_candidates, order.end(),
+                     [&](const size_t lhs, const size_t rhs) { return similarities[lhs] > similarities[rhs]; });
+    // The survivors keep their input order, the window passes decide their ranking
+    order.resize(num_candidates);
+    std::sort(order.begin(), order.end());
+
+    auto candidates = nlohmann::json::array();
+    for (const auto i : order) {
+        candidates.push_back(rows[i]);
+    }
+    return candidates;
+}
+
 std::vector<int> LlmRerank::RerankBatch(const nlohmann::json& tuples) {
     nlohmann::json data;
-    auto prompt = PromptManager::Render(user_query, tuples, AggregateFunctionType::RERANK);
+    auto prompt =
+        PromptManager::Render(user_query, tuples, AggregateFunctionType::RERANK, model.GetModelDetails().tuple_format);
     auto response = model.CallComplete(prompt);
     return response["ranking"].get<std::vector<int>>();
 };
@@ -27,6 +67,7 @@ std::vector<int> LlmRerank::RerankBatch(const nlohmann::json& tuples) {
 nlohmann::json LlmRerank::SlidingWindow(nlohmann::json& tuples) {
     int num_tuples = tuples.size();
     auto available_tokens = GetAvailableTokens();
+    BatchTokenCounter batch_tokens(model.GetModelDetails().tuple_format);
     auto accumulated_rows_tokens = 0u;
     auto batch_size = 0u;
     auto window_tuples = nlohmann::json::array();
@@ -40,14 +81,14 @@ nlohmann::json LlmRerank::SlidingWindow(nlohmann::json& tuples) {
         next_tuples.clear();
         batch_size = half_batch;
         accumulated_rows_tokens = Tiktoken::GetNumTokens(window_tuples.dump());
-        accumulated_rows_tokens += Tiktoken::GetNumTokens(PromptManager::ConstructMarkdownHeader(tuples[start_index]));
-        while (available_tokens - accumulated_rows_tokens > 0 && start_index >= 0) {
-            auto num_tokens = Tiktoken::GetNumTokens(PromptManager::ConstructMarkdownSingleTuple(tuples[start_index]));
-            if (accumulated_rows_tokens + num_tokens > static_cast<unsigned int>(available_tokens)) {
+        batch_tokens.Clear();
+        while (available_tokens - accumulated_rows_tokens - batch_tokens.Tokens() > 0 && start_index >= 0) {
+            const auto measurement = batch_tokens.Measure(tuples[start_index]);
+            if (accumulated_rows_tokens + measurement.tokens > static_cast<unsigned int>(available_tokens)) {
                 break;
             }
             window_tuples.push_back(tuples[start_index]);
-            accumulated_rows_tokens += num_tokens;
+            batch_tokens.Add(tuples[start_index], measurement);
             batch_size++;
             start_index--;
         }
@@ -75,6 +116,11 @@ void LlmRerank::Finalize(duckdb::Vector& states, duckdb::AggregateInputData& agg
                          idx_t count, idx_t offset) {
     auto states_vector = duckdb::FlatVector::GetData<AggregateFunctionState*>(states);
     auto function_instance = AggregateFunctionBase::GetInstance<LlmRerank>();
+    SetInterruptFlag(function_instance->model, aggr_input_data);
+    duckdb::ClientContext* context = nullptr;
+    if (aggr_input_data.bind_data) {
+        context = &aggr_input_data.bind_data->Cast<AggregateFunctionBindData>().context;
+    }
     for (idx_t i = 0; i < count; i++) {
         auto idx = i + offset;
         auto state_ptr = states_vector[idx];
@@ -84,6 +130,9 @@ void LlmRerank::Finalize(duckdb::Vector& states, duckdb::AggregateInputData& agg
         for (auto j = 0; j < static_cast<int>(state->value.size()); j++) {
             tuples_with_ids.push_back(state->value[j]);
         }
+        if (context) {
+            tuples_with_ids = function_instance->PruneCandidates(*context, tuples_with_ids);
+        }
         auto reranked_tuples = function_instance->SlidingWindow(tuples_with_ids);
         result.SetValue(idx, reranked_tuples.dump());
     }
@@ -7,7 +7,8 @@ void AggregateRegistry::RegisterLlmRerank(duckdb::DatabaseInstance& db) {
     auto string_concat = duckdb::AggregateFunction(
         "llm_rerank", {duckdb::LogicalType::ANY, duckdb::LogicalType::ANY, duckdb::LogicalType::ANY},
         duckdb::LogicalType::VARCHAR, duckdb::AggregateFunction::StateSize<AggregateFunctionState>,
-        LlmRerank::Initialize, LlmRerank::Operation, LlmRerank::Combine, LlmRerank::Finalize, LlmRerank::SimpleUpdate);
+        LlmRerank::Initialize, LlmRerank::Operation, LlmRerank::Combine, LlmRerank::Finalize, LlmRerank::SimpleUpdate,
+        LlmRerank::Bind);
 
     duckdb::ExtensionUtil::RegisterFunction(db, string_concat);
 }
@@ -1,19 +1,286 @@
 #include "flockmtl/functions/batch_response_builder.hpp"
 
+#include <limits>
+#include <map>
+#include <unordered_map>
+
 namespace flockmtl {
 
+// Numbers and booleans keep their JSON type so serializers do not have to quote them. DECIMAL is written as its text,
+// a double would not keep its digits.
+static nlohmann::json CastValueToJson(const duckdb::Value& value) {
+    if (value.IsNull()) {
+        return nullptr;
+    }
+    switch (value.type().id()) {
+    case duckdb::LogicalTypeId::BOOLEAN:
+        return value.GetValue<bool>();
+    case duckdb::LogicalTypeId::TINYINT:
+    case duckdb::LogicalTypeId::SMALLINT:
+    case duckdb::LogicalTypeId::INTEGER:
+    case duckdb::LogicalTypeId::BIGINT:
+        return value.GetValue<int64_t>();
+    case duckdb::LogicalTypeId::UTINYINT:
+    case duckdb::LogicalTypeId::USMALLINT:
+    case duckdb::LogicalTypeId::UINTEGER:
+    case duckdb::LogicalTypeId::UBIGINT:
+        return value.GetValue<uint64_t>();
+    case duckdb::LogicalTypeId::FLOAT:
+    case duckdb::LogicalTypeId::DOUBLE:
+        return value.GetValue<double>();
+    default:
+        return value.ToString();
+    }
+}
+
+static nlohmann::json CastStructToJson(const duckdb::Vector& struct_vector, const idx_t row) {
+    nlohmann::json json;
+    const auto struct_value = struct_vector.GetValue(row);
+    for (auto j = 0; j < static_cast<int>(duckdb::StructType::GetChildCount(struct_vector.GetType())); j++) {
+        const auto key = duckdb::StructType::GetChildName(struct_vector.GetType(), j);
+        json[key] = struct_value.IsNull() ? nlohmann::json(nullptr)
+                                          : CastValueToJson(duckdb::StructValue::GetChildren(struct_value)[j]);
+    }
+    return json;
+}
+
 std::vector<nlohmann::json> CastVectorOfStructsToJson(const duckdb::Vector& struct_vector, const int size) {
     std::vector<nlohmann::json> vector_json;
     for (auto i = 0; i < size; i++) {
-        nlohmann::json json;
-        for (auto j = 0; j < static_cast<int>(duckdb::StructType::GetChildCount(struct_vector.GetType())); j++) {
-            const auto key = duckdb::StructType::GetChildName(struct_vector.GetType(), j);
-            auto value = duckdb::StructValue::GetChildren(struct_vector.GetValue(i))[j].ToString();
-            json[key] = value;
-        }
-        vector_json.push_back(json);
+        vector_json.push_back(CastStructToJson(struct_vector, i));
     }
     return vector_json;
 }
 
+DistinctTuples CastVectorOfStructsToDistinctJson(duckdb::Vector& struct_vector, const int size) {
+    DistinctTuples distinct;
+    distinct.row_to_tuple.resize(size);
+    if (size == 0) {
+        return distinct;
+    }
+    if (struct_vector.GetVectorType() == duckdb::VectorType::CONSTANT_VECTOR) {
+        distinct.tuples.push_back(CastStructToJson(struct_vector, 0));
+        return distinct;
+    }
+
+    // Rows pointing at the same dictionary/constant entries of every field hold the same tuple, so only the first
+    // of them is serialized. Equal tuples stored at different positions are caught by the serialized form.
+    std::vector<duckdb::UnifiedVectorFormat> field_formats;
+    auto keyed = false;
+    if (struct_vector.GetVectorType() == duckdb::VectorType::FLAT_VECTOR) {
+        for (auto& field : duckdb::StructVector::GetEntries(struct_vector)) {
+            keyed = keyed || field->GetVectorType() != duckdb::VectorType::FLAT_VECTOR;
+            field_formats.emplace_back();
+            field->ToUnifiedFormat(size, field_formats.back());
+        }
+    }
+    std::map<std::vector<idx_t>, idx_t> entries_to_tuple;
+    std::unordered_map<std::string, idx_t> serialized_to_tuple;
+
+    for (auto row = 0; row < size; row++) {
+        std::vector<idx_t> entries;
+        if (keyed) {
+            entries.reserve(field_formats.size() + 1);
+            entries.push_back(duckdb::FlatVector::Validity(struct_vector).RowIsValid(row));
+            for (const auto& format : field_formats) {
+                entries.push_back(format.sel->get_index(row));
+            }
+            auto entry = entries_to_tuple.find(entries);
+            if (entry != entries_to_tuple.end()) {
+                distinct.row_to_tuple[row] = entry->second;
+                continue;
+            }
+        }
+
+        auto tuple = CastStructToJson(struct_vector, row);
+        auto inserted = serialized_to_tuple.emplace(tuple.dump(), distinct.tuples.size());
+        if (inserted.second) {
+            distinct.tuples.push_back(std::move(tuple));
+        }
+        distinct.row_to_tuple[row] = inserted.first->second;
+        if (keyed) {
+            entries_to_tuple.emplace(std::move(entries), inserted.first->second);
+        }
+    }
+    return distinct;
+}
+
+nlohmann::json JsonSchemaFromType(const duckdb::LogicalType& type) {
+    switch (type.id()) {
+    case duckdb::LogicalTypeId::STRUCT: {
+        auto properties = nlohmann::json::object();
+        auto required = nlohmann::json::array();
+        for (const auto& child : duckdb::StructType::GetChildTypes(type)) {
+            properties[child.first] = JsonSchemaFromType(child.second);
+            required.push_back(child.first);
+        }
+        return {{"type", "object"},
+                {"properties", properties},
+                {"required", required},
+                {"additionalProperties", false}};
+    }
+    case duckdb::LogicalTypeId::LIST:
+        return {{"type", "array"}, {"items", JsonSchemaFromType(duckdb::ListType::GetChildType(type))}};
+    case duckdb::LogicalTypeId::BOOLEAN:
+        return {{"type", "boolean"}};
+    case duckdb::LogicalTypeId::TINYINT:
+    case duckdb::LogicalTypeId::SMALLINT:
+    case duckdb::LogicalTypeId::INTEGER:
+    case duckdb::LogicalTypeId::BIGINT:
+    case duckdb::LogicalTypeId::UTINYINT:
+    case duckdb::LogicalTypeId::USMALLINT:
+    case duckdb::LogicalTypeId::UINTEGER:
+    case duckdb::LogicalTypeId::UBIGINT:
+        return {{"type", "integer"}};
+    case duckdb::LogicalTypeId::FLOAT:
+    case duckdb::LogicalTypeId::DOUBLE:
+    case duckdb::LogicalTypeId::DECIMAL:
+        return {{"type", "number"}};
+    default:
+        return {{"type", "string"}};
+    }
+}
+
+// Writes a JSON integer that fits in T, the others are left to the cast from text which rejects them
+template <class T>
+static bool TryWriteInteger(const nlohmann::json& json, duckdb::Vector& vector, const idx_t row) {
+    constexpr auto max = static_cast<uint64_t>(std::numeric_limits<T>::max());
+    if (json.is_number_unsigned()) {
+        const auto value = json.get<uint64_t>();
+        if (value > max) {
+            return false;
+        }
+        duckdb::FlatVector::GetData<T>(vector)[row] = static_cast<T>(value);
+        return true;
+    }
+    if (json.is_number_integer()) {
+        const auto value = json.get<int64_t>();
+        if (value < static_cast<int64_t>(std::numeric_limits<T>::min()) ||
+            (value > 0 && static_cast<uint64_t>(value) > max)) {
+            return false;
+        }
+        duckdb::FlatVector::GetData<T>(vector)[row] = static_cast<T>(value);
+        return true;
+    }
+    return false;
+}
+
+void WriteJsonToVector(const nlohmann::json& json, duckdb::Vector& vector, const idx_t row) {
+    if (json.is_null()) {
+        duckdb::FlatVector::SetNull(vector, row, true);
+        return;
+    }
+    const auto& type = vector.GetType();
+    switch (type.id()) {
+    case duckdb::LogicalTypeId::STRUCT: {
+        if (!json.is_object()) {
+            throw std::runtime_error(fmt::format("Expected a JSON object for {} but got: {}", type.ToString(),
+                                                 json.dump()));
+        }
+        auto& entries = duckdb::StructVector::GetEntries(vector);
+        for (idx_t i = 0; i < entries.size(); i++) {
+            auto field = json.find(duckdb::StructType::GetChildName(type, i));
+            WriteJsonToVector(field != json.end() ? *field : nlohmann::json(nullptr), *entries[i], row);
+        }
+        return;
+    }
+    case duckdb::LogicalTypeId::LIST: {
+        if (!json.is_array()) {
+            throw std::runtime_error(fmt::format("Expected a JSON array for {} but got: {}", type.ToString(),
+                                                 json.dump()));
+        }
+        const auto offset = duckdb::ListVector::GetListSize(vector);
+        duckdb::ListVector::Reserve(vector, offset + json.size());
+        auto& child = duckdb::ListVector::GetEntry(vector);
+        for (idx_t i = 0; i < json.size(); i++) {
+            WriteJsonToVector(json[i], child, offset + i);
+        }
+        duckdb::ListVector::SetListSize(vector, offset + json.size());
+        duckdb::FlatVector::GetData<duckdb::list_entry_t>(vector)[row] = {offset, json.size()};
+        return;
+    }
+    case duckdb::LogicalTypeId::BOOLEAN:
+        if (json.is_boolean()) {
+            duckdb::FlatVector::GetData<bool>(vector)[row] = json.get<bool>();
+            return;
+        }
+        break;
+    case duckdb::LogicalTypeId::TINYINT:
+        if (TryWriteInteger<int8_t>(json, vector, row)) {
+            return;
+        }
+        break;
+    case duckdb::LogicalTypeId::SMALLINT:
+        if (TryWriteInteger<int16_t>(json, vector, row)) {
+            return;
+        }
+        break;
+    case duckdb::LogicalTypeId::INTEGER:
+        if (TryWriteInteger<int32_t>(json, vector, row)) {
+            return;
+        }
+        break;
+    case duckdb::LogicalTypeId::BIGINT:
+        if (TryWriteInteger<int64_t>(json, vector, row)) {
+            return;
+        }
+        break;
+    case duckdb::LogicalTypeId::UTINYINT:
+        if (TryWriteInteger<uint8_t>(json, vector, row)) {
+            return;
+        }
+        break;
+    case duckdb::LogicalTypeId::USMALLINT:
+        if (TryWriteInteger<uint16_t>(json, vector, row)) {
+            return;
+        }
+        break;
+    case duckdb::LogicalTypeId::UINTEGER:
+        if (TryWriteInteger<uint32_t>(json, vector, row)) {
+            return;
+        }
+        break;
+    case duckdb::LogicalTypeId::UBIGINT:
+        if (TryWriteInteger<uint64_t>(json, vector, row)) {
+            return;
+        }
+        break;
+    case duckdb::LogicalTypeId::DOUBLE:
+        if (json.is_number()) {
+            duckdb::FlatVector::GetData<double>(vector)[row] = json.get<double>();
+            return;
+        }
+        break;
+    case duckdb::LogicalTypeId::VARCHAR:
+        duckdb::FlatVector::GetData<duckdb::string_t>(vector)[row] =
+            duckdb::StringVector::AddString(vector, json.is_string() ? json.get<std::string>() : json.dump());
+        return;
+    default:
+        break;
+    }
+    // Scalars of any other type go through DuckDB's cast from text
+    auto text = duckdb::Value(json.is_string() ? json.get<std::string>() : json.dump());
+    vector.SetValue(row, text.DefaultCastAs(type));
+}
+
+void WriteResponses(const nlohmann::json& responses, const DistinctTuples& distinct, duckdb::Vector& result) {
+    if (responses.size() != distinct.tuples.size()) {
+        throw std::runtime_error(fmt::format("Expected {} responses from the model but got {}",
+                                             distinct.tuples.size(), responses.size()));
+    }
+    result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+    auto result_data = duckdb::FlatVector::GetData<duckdb::string_t>(result);
+
+    std::vector<duckdb::string_t> written(responses.size());
+    std::vector<bool> is_written(responses.size(), false);
+    for (idx_t row = 0; row < distinct.row_to_tuple.size(); row++) {
+        const auto tuple_index = distinct.row_to_tuple[row];
+        if (!is_written[tuple_index]) {
+            written[tuple_index] = duckdb::StringVector::AddString(result, responses[tuple_index].dump());
+            is_written[tuple_index] = true;
+        }
+        result_data[row] = written[tuple_index];
+    }
+}
+
 } // namespace flockmtl
@@ -0,0 +1,214 @@
+#include "flockmtl/functions/scalar/embedding_prefilter.hpp"
+#include "flockmtl/functions/scalar/llm_filter.hpp"
+#include "flockmtl/model_manager/embedding_cache.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+namespace flockmtl {
+
+std::mutex EmbeddingPrefilter::mutex_;
+uint64_t EmbeddingPrefilter::clock_ = 0;
+std::map<std::pair<std::string, std::string>, std::pair<EmbeddingPrefilter::Entry, uint64_t>>
+    EmbeddingPrefilter::entries_;
+
+namespace {
+
+// Calibrations of the running query, by embedding model, model, function and prompt
+class PrefilterCalibrations : public duckdb::ClientContextState {
+public:
+    struct Calibration {
+        std::vector<double> similarities;
+        std::vector<double> matches;
+        int32_t chunks = 0;
+        bool done = false;
+        double cutoff = -std::numeric_limits<double>::infinity();
+    };
+
+    static PrefilterCalibrations& Get(duckdb::ClientContext& context) {
+        return *context.registered_state->GetOrCreate<PrefilterCalibrations>("flockmtl_prefilter_calibrations");
+    }
+
+    void QueryEnd() override {
+        std::lock_guard<std::mutex> lock(mutex);
+        calibrations.clear();
+    }
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Calibration> calibrations;
+};
+
+} // namespace
+
+static std::string GetEmbeddingModel(duckdb::ClientContext& context) {
+    duckdb::Value model_name;
+    if (!context.TryGetCurrentSetting("flockmtl_prefilter_model", model_name) || model_name.IsNull()) {
+        return "";
+    }
+    return model_name.ToString();
+}
+
+static double GetRecall(duckdb::ClientContext& context) {
+    duckdb::Value recall;
+    if (!context.TryGetCurrentSetting("flockmtl_prefilter_recall", recall) || recall.IsNull()) {
+        return Config::default_prefilter_recall;
+    }
+    auto value = recall.GetValue<double>();
+    if (value <= 0 || value > 1) {
+        throw std::runtime_error("flockmtl_prefilter_recall must be in (0, 1].");
+    }
+    return value;
+}
+
+bool EmbeddingPrefilter::IsEnabled(duckdb::ClientContext& context) { return !GetEmbeddingModel(context).empty(); }
+
+std::vector<bool> EmbeddingPrefilter::Apply(duckdb::ClientContext& context, const std::vector<nlohmann::json>& tuples,
+                                            const std::string& user_prompt, const ScalarFunctionType function_type,
+                                            const double threshold, Model& model) {
+    const auto embedding_model_name = GetEmbeddingModel(context);
+    Model embedding_model(nlohmann::json {{"model_name", embedding_model_name}});
+    embedding_model.SetInterruptFlag(context.interrupted);
+
+    const auto similarities = EmbeddingCache::Get().Similarities(embedding_model, user_prompt, tuples);
+
+    const auto model_details = model.GetModelDetails();
+    const auto key = fmt::format("{}\n{}\n{}\n{}", embedding_model_name, model_details.model_name,
+                                 static_cast<int>(function_type), user_prompt);
+    auto& calibrations = PrefilterCalibrations::Get(context);
+    auto cutoff = -std::numeric_limits<double>::infinity();
+    bool calibrated;
+    {
+        std::lock_guard<std::mutex> lock(calibrations.mutex);
+        const auto& calibration = calibrations.calibrations[key];
+        calibrated = calibration.done;
+        cutoff = calibration.cutoff;
+    }
+    if (!calibrated) {
+        // The chunks reaching the pre-filter before it is calibrated are sampled and kept whole. Their sampled tuples
+        // are answered through the query cache, so they are not sent twice.
+        const auto sample = SampleChunk(context, tuples, similarities, user_prompt, function_type, threshold, model);
+        Sample merged;
+        auto finished = false;
+        {
+            std::lock_guard<std::mutex> lock(calibrations.mutex);
+            auto& calibration = calibrations.calibrations[key];
+            if (!calibration.done) {
+                calibration.similarities.insert(calibration.similarities.end(), sample.similarities.begin(),
+                                                sample.similarities.end());
+                calibration.matches.insert(calibration.matches.end(), sample.matches.begin(), sample.matches.end());
+                calibration.chunks++;
+                if (calibration.matches.size() >= static_cast<size_t>(Config::default_prefilter_min_matches) ||
+                    calibration.chunks >= Config::default_prefilter_calibration_chunks) {
+                    calibration.done = true;
+                    finished = true;
+                    merged.similarities = std::move(calibration.similarities);
+                    merged.matches = std::move(calibration.matches);
+                }
+            }
+        }
+        if (finished) {
+            cutoff = Calibrate(context, merged, embedding_model_name, user_prompt);
+            std::lock_guard<std::mutex> lock(calibrations.mutex);
+            calibrations.calibrations[key].cutoff = cutoff;
+        }
+    }
+
+    std::vector<bool> keep(tuples.size());
+    int64_t dropped = 0;
+    for (size_t i = 0; i < tuples.size(); i++) {
+        keep[i] = similarities[i] >= cutoff;
+        dropped += !keep[i];
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = GetEntry(embedding_model_name, user_prompt);
+    entry.rows += static_cast<int64_t>(tuples.size());
+    entry.dropped += dropped;
+    return keep;
+}
+
+EmbeddingPrefilter::Sample EmbeddingPrefilter::SampleChunk(duckdb::ClientContext& context,
+                                                           const std::vector<nlohmann::json>& tuples,
+                                                           const std::vector<double>& similarities,
+                                                           const std::string& user_prompt,
+                                                           const ScalarFunctionType function_type,
+                                                           const double threshold, Model& model) {
+    // An evenly spaced sample, answered through the query cache
+    const auto sample_size = std::min(tuples.size(), static_cast<size_t>(Config::default_prefilter_sample_size));
+    std::vector<size_t> rows;
+    std::vector<nlohmann::json> sample_tuples;
+    for (size_t i = 0; i < sample_size; i++) {
+        rows.push_back(i * tuples.size() / sample_size);
+        sample_tuples.push_back(tuples[rows.back()]);
+    }
+    auto& cache = QueryCache::Get(context);
+    auto responses = ScalarFunctionBase::BatchAndComplete(sample_tuples, user_prompt, function_type, model, &cache);
+
+    Sample sample;
+    for (size_t i = 0; i < rows.size() && i < responses.size(); i++) {
+        sample.similarities.push_back(similarities[rows[i]]);
+        if (LlmFilter::IsSelected(responses[i], threshold)) {
+            sample.matches.push_back(similarities[rows[i]]);
+        }
+    }
+    return sample;
+}
+
+double EmbeddingPrefilter::Calibrate(duckdb::ClientContext& context, const Sample& sample,
+                                     const std::string& embedding_model, const std::string& user_prompt) {
+    // Too few matches to tell how low the similarity of a match goes, every tuple is kept
+    auto cutoff = -std::numeric_limits<double>::infinity();
+    auto matches = sample.matches;
+    if (matches.size() >= static_cast<size_t>(Config::default_prefilter_min_matches)) {
+        std::sort(matches.begin(), matches.end());
+        const auto missed = static_cast<size_t>((1 - GetRecall(context)) * static_cast<double>(matches.size()));
+        cutoff = matches[std::min(missed, matches.size() - 1)];
+    }
+
+    int64_t kept = 0, recalled = 0;
+    for (const auto similarity : sample.similarities) {
+        kept += similarity >= cutoff;
+    }
+    for (const auto similarity : matches) {
+        recalled += similarity >= cutoff;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = GetEntry(embedding_model, user_prompt);
+    entry.cutoff = cutoff;
+    entry.sample_rows = static_cast<int64_t>(sample.similarities.size());
+    entry.sample_selected = static_cast<int64_t>(matches.size());
+    entry.sample_recall = matches.empty() ? 1 : static_cast<double>(recalled) / static_cast<double>(matches.size());
+    entry.sample_precision = kept > 0 ? static_cast<double>(recalled) / static_cast<double>(kept) : 0;
+    return cutoff;
+}
+
+EmbeddingPrefilter::Entry& EmbeddingPrefilter::GetEntry(const std::string& embedding_model,
+                                                         const std::string& user_prompt) {
+    const auto key = std::make_pair(embedding_model, user_prompt);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        if (entries_.size() >= static_cast<size_t>(Config::default_prefilter_stats_size)) {
+            entries_.erase(std::min_element(entries_.begin(), entries_.end(), [](const auto& a, const auto& b) {
+                return a.second.second < b.second.second;
+            }));
+        }
+        it = entries_.emplace(key, std::make_pair(Entry {}, uint64_t {0})).first;
+        it->second.first.embedding_model = embedding_model;
+        it->second.first.prompt = user_prompt;
+    }
+    it->second.second = ++clock_;
+    return it->second.first;
+}
+
+std::vector<EmbeddingPrefilter::Entry> EmbeddingPrefilter::Snapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Entry> entries;
+    for (const auto& [key, entry] : entries_) {
+        entries.push_back(entry.first);
+    }
+    return entries;
+}
+
+} // namespace flockmtl
@@ -1,4 +1,5 @@
 #include "flockmtl/functions/scalar/llm_complete.hpp"
+#include "flockmtl/functions/scalar/query_cache.hpp"
 
 namespace flockmtl {
 
@@ -21,41 +22,40 @@ void LlmComplete::ValidateArguments(duckdb::DataChunk& args) {
     }
 }
 
-std::vector<std::string> LlmComplete::Operation(duckdb::DataChunk& args) {
+void LlmComplete::Operation(duckdb::DataChunk& args, duckdb::ClientContext& context, duckdb::Vector& result) {
     LlmComplete::ValidateArguments(args);
 
     auto model_details_json = CastVectorOfStructsToJson(args.data[0], 1)[0];
-    Model model(model_details_json);
     auto prompt_details_json = CastVectorOfStructsToJson(args.data[1], 1)[0];
     auto prompt_details = PromptManager::CreatePromptDetails(prompt_details_json);
 
-    std::vector<std::string> results;
     if (args.ColumnCount() == 2) {
+        // Same inputs for every row: one call per query, shared by all chunks and threads
         auto template_str = prompt_details.prompt;
-        auto response = model.CallComplete(template_str, false);
-
-        results.push_back(response.dump());
+        auto cache_key = fmt::format("llm_complete\n{}\n{}", model_details_json.dump(), template_str);
+        auto response = QueryCache::Get(context).GetOrCompute(cache_key, [&]() {
+            Model model(model_details_json);
+            model.SetInterruptFlag(context.interrupted);
+            return model.CallComplete(template_str, false);
+        });
+
+        result.SetVectorType(duckdb::VectorType::CONSTANT_VECTOR);
+        duckdb::ConstantVector::GetData<duckdb::string_t>(result)[0] =
+            duckdb::StringVector::AddString(result, response.dump());
     } else {
-        auto tuples = CastVectorOfStructsToJson(args.data[2], args.size());
+        Model model(model_details_json);
+        model.SetInterruptFlag(context.interrupted);
+        auto tuples = CastVectorOfStructsToDistinctJson(args.data[2], args.size());
 
-        auto responses = BatchAndComplete(tuples, prompt_details.prompt, ScalarFunctionType::COMPLETE, model);
+        auto responses = BatchAndComplete(tuples.tuples, prompt_details.prompt, ScalarFunctionType::COMPLETE, model,
+                                          &QueryCache::Get(context));
 
-        results.reserve(responses.size());
-        for (const auto& response : responses) {
-            results.push_back(response.dump());
-        }
+        WriteResponses(responses, tuples, result);
     }
-    return results;
 }
 
 void LlmComplete::Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result) {
-
-    auto results = LlmComplete::Operation(args);
-
-    auto index = 0;
-    for (const auto& res : results) {
-        result.SetValue(index++, duckdb::Value(res));
-    }
+    LlmComplete::Operation(args, state.GetContext(), result);
 }
 
 } // namespace flockmtl
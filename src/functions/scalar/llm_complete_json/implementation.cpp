@@ -1,9 +1,12 @@
 #include "flockmtl/functions/scalar/llm_complete_json.hpp"
+#include "flockmtl/functions/scalar/query_cache.hpp"
+
+#include "duckdb/execution/expression_executor.hpp"
 
 namespace flockmtl {
 
 void LlmCompleteJson::ValidateArguments(duckdb::DataChunk& args) {
-    if (args.ColumnCount() < 2 || args.ColumnCount() > 3) {
+    if (args.ColumnCount() < 2 || args.ColumnCount() > 4) {
         throw std::runtime_error("Invalid number of arguments.");
     }
 
@@ -14,49 +17,129 @@ void LlmCompleteJson::ValidateArguments(duckdb::DataChunk& args) {
         throw std::runtime_error("Prompt details must be a struct.");
     }
 
-    if (args.ColumnCount() == 3) {
+    if (args.ColumnCount() >= 3) {
         if (args.data[2].GetType().id() != duckdb::LogicalTypeId::STRUCT) {
             throw std::runtime_error("Inputs must be a struct.");
         }
     }
 }
 
-std::vector<std::string> LlmCompleteJson::Operation(duckdb::DataChunk& args) {
+// Structs and lists are written field by field, only scalars can go through the cast from text
+static void ValidateOutputType(const duckdb::LogicalType& type) {
+    switch (type.id()) {
+    case duckdb::LogicalTypeId::STRUCT:
+        for (const auto& child : duckdb::StructType::GetChildTypes(type)) {
+            ValidateOutputType(child.second);
+        }
+        return;
+    case duckdb::LogicalTypeId::LIST:
+        ValidateOutputType(duckdb::ListType::GetChildType(type));
+        return;
+    case duckdb::LogicalTypeId::MAP:
+    case duckdb::LogicalTypeId::UNION:
+    case duckdb::LogicalTypeId::ARRAY:
+        throw std::runtime_error(fmt::format(
+            "{} is not supported in the output type of llm_complete_json, use a STRUCT or a LIST instead.",
+            type.ToString()));
+    default:
+        return;
+    }
+}
+
+duckdb::unique_ptr<duckdb::FunctionData>
+LlmCompleteJson::Bind(duckdb::ClientContext& context, duckdb::ScalarFunction& bound_function,
+                      duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments) {
+    // One JSON answer per tuple cannot be escalated field by field
+    if (!arguments.empty() && arguments[0]->IsFoldable() &&
+        arguments[0]->return_type.id() == duckdb::LogicalTypeId::STRUCT) {
+        duckdb::Vector model_vector(duckdb::ExpressionExecutor::EvaluateScalar(context, *arguments[0]));
+        if (!Model::GetCascade(CastVectorOfStructsToJson(model_vector, 1)[0]).empty()) {
+            throw std::runtime_error("llm_complete_json does not support model cascades.");
+        }
+    }
+    if (arguments.size() != 4) {
+        return nullptr;
+    }
+    auto& output = *arguments[3];
+    auto output_type = output.return_type;
+    if (output_type.id() == duckdb::LogicalTypeId::VARCHAR) {
+        if (!output.IsFoldable()) {
+            throw std::runtime_error("The output type of llm_complete_json must be a constant.");
+        }
+        auto type_name = duckdb::ExpressionExecutor::EvaluateScalar(context, output);
+        output_type = duckdb::TransformStringToLogicalType(type_name.ToString(), context);
+    }
+    if (output_type.id() != duckdb::LogicalTypeId::STRUCT) {
+        throw std::runtime_error("The output type of llm_complete_json must be a STRUCT.");
+    }
+    ValidateOutputType(output_type);
+    bound_function.return_type = output_type;
+    return nullptr;
+}
+
+void LlmCompleteJson::Operation(duckdb::DataChunk& args, duckdb::ClientContext& context, duckdb::Vector& result) {
     LlmCompleteJson::ValidateArguments(args);
 
     auto model_details_json = CastVectorOfStructsToJson(args.data[0], 1)[0];
-    Model model(model_details_json);
     auto prompt_details_json = CastVectorOfStructsToJson(args.data[1], 1)[0];
     auto prompt_details = PromptManager::CreatePromptDetails(prompt_details_json);
 
-    std::vector<std::string> results;
+    const auto& result_type = result.GetType();
     if (args.ColumnCount() == 2) {
+        // Same inputs for every row: one call per query, shared by all chunks and threads
         auto template_str = prompt_details.prompt;
         template_str += "\nThe Ouput should be in JSON format.";
-        auto response = model.CallComplete(template_str);
+        auto cache_key = fmt::format("llm_complete_json\n{}\n{}", model_details_json.dump(), template_str);
+        auto response = QueryCache::Get(context).GetOrCompute(cache_key, [&]() {
+            Model model(model_details_json);
+            model.SetInterruptFlag(context.interrupted);
+            return model.CallComplete(template_str);
+        });
 
-        results.push_back(response.dump());
+        result.SetVectorType(duckdb::VectorType::CONSTANT_VECTOR);
+        duckdb::ConstantVector::GetData<duckdb::string_t>(result)[0] =
+            duckdb::StringVector::AddString(result, response.dump());
     } else {
-        auto tuples = CastVectorOfStructsToJson(args.data[2], args.size());
+        Model model(model_details_json);
+        model.SetInterruptFlag(context.interrupted);
+        CompletionOptions options;
+        if (result_type.id() == duckdb::LogicalTypeId::STRUCT) {
+            // The provider enforces the shape of the whole response, the id-tagged tuples list included
+            nlohmann::json answer_schema = {
+                {"type", "object"},
+                {"properties", {{"id", {{"type", "integer"}}}, {"response", JsonSchemaFromType(result_type)}}},
+                {"required", {"id", "response"}},
+                {"additionalProperties", false}};
+            nlohmann::json tuples_schema = {{"type", "array"}, {"items", answer_schema}};
+            options.response_schema = {{"type", "object"},
+                                       {"properties", {{"tuples", tuples_schema}}},
+                                       {"required", nlohmann::json::array({"tuples"})},
+                                       {"additionalProperties", false}};
+        }
+        auto tuples = CastVectorOfStructsToDistinctJson(args.data[2], args.size());
 
-        auto responses = BatchAndComplete(tuples, prompt_details.prompt, ScalarFunctionType::COMPLETE_JSON, model);
+        // Typed answers follow a schema the cache key does not capture
+        auto* cache = result_type.id() == duckdb::LogicalTypeId::STRUCT ? nullptr : &QueryCache::Get(context);
+        auto responses = BatchAndComplete(tuples.tuples, prompt_details.prompt, ScalarFunctionType::COMPLETE_JSON,
+                                          model, cache, options);
 
-        results.reserve(responses.size());
-        for (const auto& response : responses) {
-            results.push_back(response.dump());
+        if (result_type.id() != duckdb::LogicalTypeId::STRUCT) {
+            WriteResponses(responses, tuples, result);
+            return;
+        }
+        if (responses.size() != tuples.tuples.size()) {
+            throw std::runtime_error(fmt::format("Expected {} responses from the model but got {}",
+                                                 tuples.tuples.size(), responses.size()));
+        }
+        result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+        for (idx_t row = 0; row < tuples.row_to_tuple.size(); row++) {
+            WriteJsonToVector(responses[tuples.row_to_tuple[row]], result, row);
         }
     }
-    return results;
 }
 
 void LlmCompleteJson::Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result) {
-
-    auto results = LlmCompleteJson::Operation(args);
-
-    auto index = 0;
-    for (const auto& res : results) {
-        result.SetValue(index++, duckdb::Value(res));
-    }
+    LlmCompleteJson::Operation(args, state.GetContext(), result);
 }
 
 } // namespace flockmtl
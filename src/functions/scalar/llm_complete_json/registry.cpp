@@ -6,7 +6,7 @@ namespace flockmtl {
 void ScalarRegistry::RegisterLlmCompleteJson(duckdb::DatabaseInstance& db) {
     duckdb::ExtensionUtil::RegisterFunction(
         db, duckdb::ScalarFunction("llm_complete_json", {}, duckdb::LogicalType::JSON(), LlmCompleteJson::Execute,
-                                   nullptr, nullptr, nullptr, nullptr, duckdb::LogicalType::ANY));
+                                   LlmCompleteJson::Bind, nullptr, nullptr, nullptr, duckdb::LogicalType::ANY));
 }
 
 } // namespace flockmtl
@@ -1,4 +1,5 @@
 #include "flockmtl/functions/scalar/llm_embedding.hpp"
+#include "flockmtl/model_manager/embedding_cache.hpp"
 
 namespace flockmtl {
 
@@ -14,41 +15,46 @@ void LlmEmbedding::ValidateArguments(duckdb::DataChunk& args) {
     }
 }
 
-std::vector<duckdb::vector<duckdb::Value>> LlmEmbedding::Operation(duckdb::DataChunk& args) {
+void LlmEmbedding::Operation(duckdb::DataChunk& args, duckdb::ClientContext& context, duckdb::Vector& result) {
     LlmEmbedding::ValidateArguments(args);
 
     auto inputs = CastVectorOfStructsToJson(args.data[1], args.size());
     auto model_details_json = CastVectorOfStructsToJson(args.data[0], 1)[0];
     Model model(model_details_json);
+    model.SetInterruptFlag(context.interrupted);
 
     std::vector<std::string> prepared_inputs;
     for (auto& row : inputs) {
-        std::string concat_input;
-        for (auto& item : row.items()) {
-            concat_input += item.value().get<std::string>() + " ";
-        }
-        prepared_inputs.push_back(concat_input);
+        prepared_inputs.push_back(EmbeddingCache::TupleText(row));
     }
 
     auto embeddings = model.CallEmbedding(prepared_inputs);
-    std::vector<duckdb::vector<duckdb::Value>> results;
-    for (size_t index = 0; index < embeddings.size(); index++) {
-        duckdb::vector<duckdb::Value> embedding;
-        for (auto& value : embeddings[index]) {
-            embedding.push_back(duckdb::Value(static_cast<double>(value)));
+    if (embeddings.size() != args.size()) {
+        throw std::runtime_error(
+            fmt::format("Expected {} embeddings from the model but got {}", args.size(), embeddings.size()));
+    }
+
+    // Appended straight into the list's child vector
+    auto offset = duckdb::ListVector::GetListSize(result);
+    idx_t total_size = offset;
+    for (const auto& embedding : embeddings) {
+        total_size += embedding.size();
+    }
+    duckdb::ListVector::Reserve(result, total_size);
+    result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+    auto list_entries = duckdb::FlatVector::GetData<duckdb::list_entry_t>(result);
+    auto values = duckdb::FlatVector::GetData<double>(duckdb::ListVector::GetEntry(result));
+    for (idx_t row = 0; row < embeddings.size(); row++) {
+        list_entries[row] = duckdb::list_entry_t(offset, embeddings[row].size());
+        for (const auto& value : embeddings[row]) {
+            values[offset++] = value.get<double>();
         }
-        results.push_back(embedding);
     }
-    return results;
+    duckdb::ListVector::SetListSize(result, offset);
 }
 
 void LlmEmbedding::Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result) {
-    auto results = LlmEmbedding::Operation(args);
-
-    auto index = 0;
-    for (const auto& res : results) {
-        result.SetValue(index++, duckdb::Value::LIST(res));
-    }
+    LlmEmbedding::Operation(args, state.GetContext(), result);
 }
 
 } // namespace flockmtl
@@ -1,9 +1,12 @@
 #include "flockmtl/functions/scalar/llm_filter.hpp"
+#include "flockmtl/functions/scalar/embedding_prefilter.hpp"
+
+#include "duckdb/execution/expression_executor.hpp"
 
 namespace flockmtl {
 
 void LlmFilter::ValidateArguments(duckdb::DataChunk& args) {
-    if (args.ColumnCount() < 2 || args.ColumnCount() > 3) {
+    if (args.ColumnCount() < 2 || args.ColumnCount() > 4) {
         throw std::runtime_error("Invalid number of arguments.");
     }
 
@@ -14,40 +17,132 @@ void LlmFilter::ValidateArguments(duckdb::DataChunk& args) {
         throw std::runtime_error("Prompt details must be a struct.");
     }
 
-    if (args.ColumnCount() == 3) {
+    if (args.ColumnCount() >= 3) {
         if (args.data[2].GetType().id() != duckdb::LogicalTypeId::STRUCT) {
             throw std::runtime_error("Inputs must be a struct.");
         }
     }
+
+    if (args.ColumnCount() == 4) {
+        if (!args.data[3].GetType().IsNumeric()) {
+            throw std::runtime_error("Threshold must be a number.");
+        }
+    }
+}
+
+duckdb::unique_ptr<duckdb::FunctionData>
+LlmFilter::Bind(duckdb::ClientContext& context, duckdb::ScalarFunction& bound_function,
+                duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments) {
+    if (arguments.size() != 4) {
+        return nullptr;
+    }
+    if (!arguments[3]->IsFoldable()) {
+        throw std::runtime_error("The threshold of llm_filter must be a constant.");
+    }
+    GetThreshold(duckdb::ExpressionExecutor::EvaluateScalar(context, *arguments[3]));
+    return nullptr;
+}
+
+ScalarFunctionType LlmFilter::GetFunctionType(duckdb::ClientContext& context, const bool has_threshold) {
+    if (has_threshold) {
+        return ScalarFunctionType::FILTER_SCORE;
+    }
+    duckdb::Value filter_ids;
+    if (context.TryGetCurrentSetting("flockmtl_filter_ids", filter_ids) && !filter_ids.GetValue<bool>()) {
+        return ScalarFunctionType::FILTER;
+    }
+    return ScalarFunctionType::FILTER_IDS;
+}
+
+double LlmFilter::GetThreshold(const duckdb::Value& threshold) {
+    if (threshold.IsNull()) {
+        return DEFAULT_THRESHOLD;
+    }
+    auto value = threshold.GetValue<double>();
+    if (value < 0 || value > 1) {
+        throw std::runtime_error("Threshold must be between 0 and 1.");
+    }
+    return value;
 }
 
-std::vector<std::string> LlmFilter::Operation(duckdb::DataChunk& args) {
+bool LlmFilter::IsSelected(const nlohmann::json& response, const double threshold) {
+    if (response.is_boolean()) {
+        return response.get<bool>();
+    }
+    if (response.is_number()) {
+        return response.get<double>() >= threshold;
+    }
+    if (response.is_string()) {
+        auto text = duckdb::StringUtil::Lower(response.get<std::string>());
+        if (text == "true" || text == "yes") {
+            return true;
+        }
+        try {
+            return std::stod(text) >= threshold;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return false;
+}
+
+std::vector<bool> LlmFilter::Operation(duckdb::DataChunk& args, duckdb::ClientContext& context) {
     LlmFilter::ValidateArguments(args);
 
     auto model_details_json = CastVectorOfStructsToJson(args.data[0], 1)[0];
     Model model(model_details_json);
+    model.SetInterruptFlag(context.interrupted);
     auto prompt_details_json = CastVectorOfStructsToJson(args.data[1], 1)[0];
     auto prompt_details = PromptManager::CreatePromptDetails(prompt_details_json);
 
-    auto tuples = CastVectorOfStructsToJson(args.data[2], args.size());
+    const auto has_threshold = args.ColumnCount() == 4;
+    const auto threshold = has_threshold ? GetThreshold(args.data[3].GetValue(0)) : DEFAULT_THRESHOLD;
 
-    auto responses = BatchAndComplete(tuples, prompt_details.prompt, ScalarFunctionType::FILTER, model);
+    auto tuples = CastVectorOfStructsToDistinctJson(args.data[2], args.size());
+    const auto function_type = GetFunctionType(context, has_threshold);
 
-    std::vector<std::string> results;
-    results.reserve(responses.size());
-    for (const auto& response : responses) {
-        results.push_back(response.dump());
+    // Tuples the embedding pre-filter rules out are never sent to the model
+    std::vector<bool> candidate(tuples.tuples.size(), true);
+    if (EmbeddingPrefilter::IsEnabled(context)) {
+        candidate = EmbeddingPrefilter::Apply(context, tuples.tuples, prompt_details.prompt, function_type, threshold,
+                                              model);
+    }
+    std::vector<nlohmann::json> candidates;
+    for (size_t i = 0; i < tuples.tuples.size(); i++) {
+        if (candidate[i]) {
+            candidates.push_back(tuples.tuples[i]);
+        }
+    }
+
+    auto responses =
+        BatchAndComplete(candidates, prompt_details.prompt, function_type, model, &QueryCache::Get(context));
+    if (responses.size() != candidates.size()) {
+        throw std::runtime_error(
+            fmt::format("Expected {} responses from the model but got {}", candidates.size(), responses.size()));
     }
 
+    std::vector<bool> selected(tuples.tuples.size(), false);
+    for (size_t i = 0, answered = 0; i < tuples.tuples.size(); i++) {
+        if (candidate[i]) {
+            selected[i] = IsSelected(responses[answered++], threshold);
+        }
+    }
+
+    std::vector<bool> results;
+    results.reserve(tuples.row_to_tuple.size());
+    for (const auto tuple_index : tuples.row_to_tuple) {
+        results.push_back(selected[tuple_index]);
+    }
     return results;
 }
 
 void LlmFilter::Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result) {
-    auto results = LlmFilter::Operation(args);
+    auto results = LlmFilter::Operation(args, state.GetContext());
 
-    auto index = 0;
-    for (const auto& res : results) {
-        result.SetValue(index++, duckdb::Value(res));
+    result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+    auto result_data = duckdb::FlatVector::GetData<bool>(result);
+    for (idx_t i = 0; i < results.size(); i++) {
+        result_data[i] = results[i];
     }
 }
 
@@ -4,9 +4,9 @@
 namespace flockmtl {
 
 void ScalarRegistry::RegisterLlmFilter(duckdb::DatabaseInstance& db) {
-    duckdb::ExtensionUtil::RegisterFunction(db, duckdb::ScalarFunction("llm_filter", {}, duckdb::LogicalType::VARCHAR,
-                                                                       LlmFilter::Execute, nullptr, nullptr, nullptr,
-                                                                       nullptr, duckdb::LogicalType::ANY));
+    duckdb::ExtensionUtil::RegisterFunction(
+        db, duckdb::ScalarFunction("llm_filter", {}, duckdb::LogicalType::BOOLEAN, LlmFilter::Execute, LlmFilter::Bind,
+                                   nullptr, nullptr, nullptr, duckdb::LogicalType::ANY));
 }
 
 } // namespace flockmtl
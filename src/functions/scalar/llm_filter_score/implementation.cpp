@@ -0,0 +1,72 @@
+#include "flockmtl/functions/scalar/llm_filter_score.hpp"
+
+namespace flockmtl {
+
+void LlmFilterScore::ValidateArguments(duckdb::DataChunk& args) {
+    if (args.ColumnCount() != 3) {
+        throw std::runtime_error("Invalid number of arguments.");
+    }
+
+    if (args.data[0].GetType().id() != duckdb::LogicalTypeId::STRUCT) {
+        throw std::runtime_error("Model details must be a string.");
+    }
+    if (args.data[1].GetType().id() != duckdb::LogicalTypeId::STRUCT) {
+        throw std::runtime_error("Prompt details must be a struct.");
+    }
+    if (args.data[2].GetType().id() != duckdb::LogicalTypeId::STRUCT) {
+        throw std::runtime_error("Inputs must be a struct.");
+    }
+}
+
+double LlmFilterScore::GetScore(const nlohmann::json& response) {
+    if (response.is_number()) {
+        return response.get<double>();
+    }
+    // Providers without log probabilities only give the answer itself
+    if (response.is_boolean()) {
+        return response.get<bool>() ? 1.0 : 0.0;
+    }
+    if (response.is_string()) {
+        auto text = duckdb::StringUtil::Lower(response.get<std::string>());
+        return text == "true" || text == "yes" ? 1.0 : 0.0;
+    }
+    return 0.0;
+}
+
+std::vector<double> LlmFilterScore::Operation(duckdb::DataChunk& args, duckdb::ClientContext& context) {
+    LlmFilterScore::ValidateArguments(args);
+
+    auto model_details_json = CastVectorOfStructsToJson(args.data[0], 1)[0];
+    Model model(model_details_json);
+    model.SetInterruptFlag(context.interrupted);
+    auto prompt_details_json = CastVectorOfStructsToJson(args.data[1], 1)[0];
+    auto prompt_details = PromptManager::CreatePromptDetails(prompt_details_json);
+
+    auto tuples = CastVectorOfStructsToDistinctJson(args.data[2], args.size());
+
+    auto responses = BatchAndComplete(tuples.tuples, prompt_details.prompt, ScalarFunctionType::FILTER_PROBABILITY,
+                                      model, &QueryCache::Get(context));
+    if (responses.size() != tuples.tuples.size()) {
+        throw std::runtime_error(fmt::format("Expected {} responses from the model but got {}", tuples.tuples.size(),
+                                             responses.size()));
+    }
+
+    std::vector<double> results;
+    results.reserve(tuples.row_to_tuple.size());
+    for (const auto tuple_index : tuples.row_to_tuple) {
+        results.push_back(GetScore(responses[tuple_index]));
+    }
+    return results;
+}
+
+void LlmFilterScore::Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result) {
+    auto results = LlmFilterScore::Operation(args, state.GetContext());
+
+    result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+    auto result_data = duckdb::FlatVector::GetData<double>(result);
+    for (idx_t i = 0; i < results.size(); i++) {
+        result_data[i] = results[i];
+    }
+}
+
+} // namespace flockmtl
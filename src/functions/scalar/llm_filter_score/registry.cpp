@@ -0,0 +1,12 @@
+#include "flockmtl/functions/scalar/llm_filter_score.hpp"
+#include "flockmtl/registry/registry.hpp"
+
+namespace flockmtl {
+
+void ScalarRegistry::RegisterLlmFilterScore(duckdb::DatabaseInstance& db) {
+    duckdb::ExtensionUtil::RegisterFunction(
+        db, duckdb::ScalarFunction("llm_filter_score", {}, duckdb::LogicalType::DOUBLE, LlmFilterScore::Execute,
+                                   nullptr, nullptr, nullptr, nullptr, duckdb::LogicalType::ANY));
+}
+
+} // namespace flockmtl
@@ -0,0 +1,59 @@
+#include "flockmtl/functions/scalar/query_cache.hpp"
+
+namespace flockmtl {
+
+QueryCache& QueryCache::Get(duckdb::ClientContext& context) {
+    return *context.registered_state->GetOrCreate<QueryCache>("flockmtl_query_cache");
+}
+
+nlohmann::json QueryCache::GetOrCompute(const std::string& key, const std::function<nlohmann::json()>& compute) {
+    std::promise<nlohmann::json> promise;
+    std::shared_future<nlohmann::json> response;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto entry = responses_.find(key);
+        if (entry != responses_.end()) {
+            response = entry->second;
+        } else {
+            responses_.emplace(key, promise.get_future().share());
+        }
+    }
+    if (response.valid()) {
+        return response.get();
+    }
+
+    try {
+        auto result = compute();
+        promise.set_value(result);
+        return result;
+    } catch (...) {
+        // Waiters see the same error, later calls retry
+        promise.set_exception(std::current_exception());
+        std::lock_guard<std::mutex> lock(mutex_);
+        responses_.erase(key);
+        throw;
+    }
+}
+
+bool QueryCache::LookupTuple(const std::string& key, nlohmann::json& response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto entry = tuple_responses_.find(key);
+    if (entry == tuple_responses_.end()) {
+        return false;
+    }
+    response = entry->second;
+    return true;
+}
+
+void QueryCache::StoreTuple(const std::string& key, const nlohmann::json& response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tuple_responses_[key] = response;
+}
+
+void QueryCache::QueryEnd() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    responses_.clear();
+    tuple_responses_.clear();
+}
+
+} // namespace flockmtl
@@ -1,75 +1,244 @@
 #include "flockmtl/functions/scalar/scalar.hpp"
+#include "flockmtl/model_manager/cascade_stats.hpp"
+
+#include <algorithm>
+#include <numeric>
 
 namespace flockmtl {
 
-nlohmann::json ScalarFunctionBase::Complete(const nlohmann::json& tuples, const std::string& user_prompt,
-                                            ScalarFunctionType function_type, Model& model) {
-    nlohmann::json data;
-    const auto prompt = PromptManager::Render(user_prompt, tuples, function_type);
-    auto response = model.CallComplete(prompt);
-    return response["tuples"];
+// The probability a FILTER_PROBABILITY answer gave to true, read from the token log probabilities when the provider
+// reported them.
+static nlohmann::json ToProbability(const nlohmann::json& response, const nlohmann::json& probabilities,
+                                    const size_t value_index) {
+    if (probabilities.is_array() && value_index < probabilities.size() && probabilities[value_index].is_number()) {
+        return probabilities[value_index];
+    }
+    if (response.is_boolean()) {
+        return response.get<bool>() ? 1.0 : 0.0;
+    }
+    return response;
+}
+
+ScalarFunctionBase::CompletedBatch ScalarFunctionBase::Complete(const nlohmann::json& tuples,
+                                                                const std::string& user_prompt,
+                                                                ScalarFunctionType function_type, Model& model,
+                                                                const CompletionOptions& options) {
+    // Reused across batches so rendering does not reallocate the prompt every time
+    thread_local PromptMessages prompt;
+    PromptManager::RenderInto(prompt, user_prompt, tuples, function_type, model.GetModelDetails().tuple_format);
+
+    CompletedBatch batch;
+    batch.responses.resize(tuples.size());
+    batch.answered.assign(tuples.size(), false);
+
+    const auto with_probabilities = function_type == ScalarFunctionType::FILTER_PROBABILITY;
+    auto request_options = options;
+    request_options.logprobs = with_probabilities;
+
+    nlohmann::json response;
+    try {
+        response = model.CallComplete(prompt, true, request_options);
+    } catch (const ExceededMaxOutputTokensError& error) {
+        // The complete answers are kept, the caller requests the others again in smaller batches. A cut list of
+        // ids cannot tell the unlisted tuples apart from the rejected ones, so it is dropped.
+        batch.truncated = true;
+        if (function_type == ScalarFunctionType::FILTER_IDS || error.partial_content.empty()) {
+            return batch;
+        }
+        try {
+            response = ResponseParser::Parse(error.partial_content);
+        } catch (const std::exception&) {
+            return batch;
+        }
+    }
+    if (!response.is_object() || !response.contains("tuples") || !response["tuples"].is_array()) {
+        return batch;
+    }
+    const auto& answers = response["tuples"];
+    batch.output_tokens = Tiktoken::GetNumTokens(answers.dump());
+
+    if (function_type == ScalarFunctionType::FILTER_IDS) {
+        auto booleans = ResponseParser::IdsToBooleans(answers, tuples.size());
+        std::move(booleans.begin(), booleans.end(), batch.responses.begin());
+        batch.answered.assign(tuples.size(), true);
+        return batch;
+    }
+
+    // The probabilities follow the order of the response values in the completion text
+    const auto probabilities = response.value(IProvider::PROBABILITIES_KEY, nlohmann::json());
+    const auto matches = ResponseParser::MatchAnswers(answers, tuples.size(), !batch.truncated);
+    for (size_t i = 0; i < matches.size(); i++) {
+        if (matches[i].answer < 0) {
+            continue;
+        }
+        const auto& answer = answers[matches[i].answer];
+        const auto is_wrapped = answer.is_object() && answer.contains("response");
+        const auto& value = is_wrapped ? answer["response"] : answer;
+        batch.responses[i] = with_probabilities ? ToProbability(value, probabilities, matches[i].value) : value;
+        batch.answered[i] = true;
+    }
+    return batch;
 };
 
 nlohmann::json ScalarFunctionBase::BatchAndComplete(const std::vector<nlohmann::json>& tuples,
                                                     const std::string& user_prompt,
-                                                    const ScalarFunctionType function_type, Model& model) {
-    const auto llm_template = PromptManager::GetTemplate(function_type);
+                                                    const ScalarFunctionType function_type, Model& model,
+                                                    QueryCache* cache, const CompletionOptions& options) {
+    if (!model.GetModelDetails().cascade.empty()) {
+        // Bind rejects it already when the model is a constant
+        if (function_type == ScalarFunctionType::COMPLETE_JSON) {
+            throw std::runtime_error("llm_complete_json does not support model cascades.");
+        }
+        return CascadeAndComplete(tuples, user_prompt, function_type, model, cache);
+    }
+    const auto tuple_format = model.GetModelDetails().tuple_format;
 
     int num_tokens_meta_and_user_prompt = 0;
     num_tokens_meta_and_user_prompt += Tiktoken::GetNumTokens(user_prompt);
-    num_tokens_meta_and_user_prompt += Tiktoken::GetNumTokens(llm_template);
+    num_tokens_meta_and_user_prompt += PromptManager::GetStaticTokens(function_type);
     const int available_tokens = model.GetModelDetails().context_window - num_tokens_meta_and_user_prompt;
 
-    auto responses = nlohmann::json::array();
-
     if (available_tokens < 0) {
         throw std::runtime_error("The total number of tokens in the prompt exceeds the model's maximum token limit");
+    }
+
+    std::vector<nlohmann::json> responses(tuples.size());
+    // Tuples still waiting for an answer, the first attempt sends all of them and the retries only the missing ones
+    std::vector<size_t> pending;
+    std::vector<std::string> cache_keys;
+    if (cache) {
+        const auto model_details = model.GetModelDetails();
+        // The prompt itself, a hash could collide; the dumped tuple holds no newline so the last one ends the prompt
+        const auto prefix = fmt::format("{}\n{}\n{}\n{}\n", model_details.provider_name, model_details.model,
+                                        static_cast<int>(function_type), user_prompt);
+        for (size_t i = 0; i < tuples.size(); i++) {
+            cache_keys.push_back(prefix + tuples[i].dump());
+            if (!cache->LookupTuple(cache_keys[i], responses[i])) {
+                pending.push_back(i);
+            }
+        }
     } else {
+        pending.resize(tuples.size());
+        std::iota(pending.begin(), pending.end(), 0);
+    }
+    const auto requested = pending;
 
-        auto accumulated_tuples_tokens = 0u;
-        auto batch_tuples = nlohmann::json::array();
-        auto batch_size = tuples.size();
-        int start_index = 0;
-
-        do {
-            accumulated_tuples_tokens +=
-                Tiktoken::GetNumTokens(PromptManager::ConstructMarkdownHeader(tuples[start_index]));
-            while (accumulated_tuples_tokens < static_cast<unsigned int>(available_tokens) &&
-                   start_index < static_cast<int>(tuples.size()) && batch_tuples.size() < batch_size) {
-                const auto num_tokens =
-                    Tiktoken::GetNumTokens(PromptManager::ConstructMarkdownSingleTuple(tuples[start_index]));
-                if (accumulated_tuples_tokens + num_tokens > static_cast<unsigned int>(available_tokens)) {
+    BatchTokenCounter batch_tokens(tuple_format);
+    size_t batch_size = tuples.size();
+    for (auto attempt = 0; !pending.empty(); attempt++) {
+        if (attempt > Config::default_max_retries) {
+            throw std::runtime_error(fmt::format("The model did not answer {} of {} tuples after {} retries; increase "
+                                                 "max_output_tokens if the responses are long",
+                                                 pending.size(), tuples.size(), Config::default_max_retries));
+        }
+
+        std::vector<size_t> unanswered;
+        size_t start_index = 0;
+        while (start_index < pending.size()) {
+            auto batch_tuples = nlohmann::json::array();
+            batch_tokens.Clear();
+            while (start_index + batch_tuples.size() < pending.size() && batch_tuples.size() < batch_size) {
+                auto tuple = tuples[pending[start_index + batch_tuples.size()]];
+                // Ids are local to the batch so they stay short
+                tuple["flockmtl_tuple_id"] = batch_tuples.size();
+                const auto measurement = batch_tokens.Measure(tuple);
+                if (!batch_tuples.empty() && measurement.tokens > static_cast<unsigned int>(available_tokens)) {
                     break;
                 }
-                batch_tuples.push_back(tuples[start_index]);
-                accumulated_tuples_tokens += num_tokens;
-                start_index++;
+                batch_tokens.Add(tuple, measurement);
+                batch_tuples.push_back(std::move(tuple));
             }
 
-            nlohmann::json response;
-            try {
-                response = Complete(batch_tuples, user_prompt, function_type, model);
-            } catch (const ExceededMaxOutputTokensError&) {
-                batch_tuples.clear();
-                const auto new_batch_size = static_cast<int>(batch_size * 0.1);
-                batch_size = batch_size == 1 ? new_batch_size == 0 : new_batch_size;
-                accumulated_tuples_tokens = 0;
-                start_index = 0;
-                continue;
+            auto batch = Complete(batch_tuples, user_prompt, function_type, model, options);
+            size_t answered = 0;
+            for (size_t i = 0; i < batch_tuples.size(); i++) {
+                if (batch.answered[i]) {
+                    responses[pending[start_index + i]] = std::move(batch.responses[i]);
+                    answered++;
+                } else {
+                    unanswered.push_back(pending[start_index + i]);
+                }
             }
-            auto output_tokens_per_tuple = Tiktoken::GetNumTokens(response.dump()) / batch_tuples.size();
+            start_index += batch_tuples.size();
 
-            batch_size = model.GetModelDetails().max_output_tokens / output_tokens_per_tuple;
-            batch_tuples.clear();
-            accumulated_tuples_tokens = 0;
-
-            for (const auto& tuple : response) {
-                responses.push_back(tuple);
+            if (batch.truncated) {
+                // What fit before the cut bounds the next batches
+                batch_size = std::max<size_t>(1, answered > 0 ? answered * 9 / 10 : batch_tuples.size() / 10);
+            } else if (function_type != ScalarFunctionType::FILTER_IDS && batch.output_tokens > 0) {
+                // Only the selected ids are generated under FILTER_IDS, so the output does not bound its batch size
+                const auto output_tokens_per_tuple =
+                    std::max<size_t>(1, batch.output_tokens / std::max<size_t>(1, answered));
+                batch_size = std::max<size_t>(1, model.GetModelDetails().max_output_tokens / output_tokens_per_tuple);
             }
+        }
+        pending = std::move(unanswered);
+    }
 
-        } while (start_index < static_cast<int>(tuples.size()));
+    if (cache) {
+        for (const auto i : requested) {
+            cache->StoreTuple(cache_keys[i], responses[i]);
+        }
     }
+    return responses;
+}
 
+nlohmann::json ScalarFunctionBase::CascadeAndComplete(const std::vector<nlohmann::json>& tuples,
+                                                      const std::string& user_prompt,
+                                                      const ScalarFunctionType function_type, Model& model,
+                                                      QueryCache* cache) {
+    const auto model_details = model.GetModelDetails();
+    const auto is_filter = function_type != ScalarFunctionType::COMPLETE;
+    // Probabilities from the token log probabilities are kept as the confidence, the other filters report a score
+    auto stage_type = is_filter ? ScalarFunctionType::FILTER_SCORE : ScalarFunctionType::COMPLETE_SCORED;
+    if (function_type == ScalarFunctionType::FILTER_PROBABILITY) {
+        stage_type = function_type;
+    }
+
+    std::vector<nlohmann::json> responses(tuples.size());
+    std::vector<size_t> pending(tuples.size());
+    std::iota(pending.begin(), pending.end(), 0);
+    for (size_t stage = 0; stage <= model_details.cascade.size() && !pending.empty(); stage++) {
+        auto stage_model = stage == 0 ? model.WithoutCascade() : model.Escalate(model_details.cascade[stage - 1]);
+        std::vector<nlohmann::json> stage_tuples;
+        stage_tuples.reserve(pending.size());
+        for (const auto i : pending) {
+            stage_tuples.push_back(tuples[i]);
+        }
+        auto answers = BatchAndComplete(stage_tuples, user_prompt, stage_type, stage_model, cache);
+
+        const auto last_stage = stage == model_details.cascade.size();
+        std::vector<size_t> escalated;
+        for (size_t k = 0; k < pending.size(); k++) {
+            nlohmann::json answer;
+            double confidence = 0;
+            if (is_filter) {
+                // A score far from 0.5 either way is a confident answer
+                auto score = 0.5;
+                if (answers[k].is_number()) {
+                    score = answers[k].get<double>();
+                } else if (answers[k].is_boolean()) {
+                    score = answers[k].get<bool>() ? 1.0 : 0.0;
+                }
+                confidence = std::max(score, 1 - score);
+                answer = score;
+            } else if (answers[k].is_object()) {
+                answer = answers[k].contains("answer") ? answers[k]["answer"] : nlohmann::json();
+                if (answers[k].contains("confidence") && answers[k]["confidence"].is_number()) {
+                    confidence = answers[k]["confidence"].get<double>();
+                }
+            } else {
+                answer = answers[k];
+            }
+            if (last_stage || confidence >= model_details.cascade_threshold) {
+                responses[pending[k]] = std::move(answer);
+            } else {
+                escalated.push_back(pending[k]);
+            }
+        }
+        CascadeStats::Record(static_cast<int32_t>(stage), stage_model.GetModelDetails().model_name,
+                             static_cast<int64_t>(pending.size()), static_cast<int64_t>(escalated.size()));
+        pending = std::move(escalated);
+    }
     return responses;
 }
 
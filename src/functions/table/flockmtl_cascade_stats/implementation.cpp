@@ -0,0 +1,39 @@
+#include "flockmtl/functions/table/flockmtl_cascade_stats.hpp"
+
+namespace flockmtl {
+
+duckdb::unique_ptr<duckdb::FunctionData> FlockmtlCascadeStats::Bind(duckdb::ClientContext& context,
+                                                                    duckdb::TableFunctionBindInput& input,
+                                                                    duckdb::vector<duckdb::LogicalType>& return_types,
+                                                                    duckdb::vector<std::string>& names) {
+    names = {"stage", "model", "rows", "escalated", "escalation_rate"};
+    return_types = {duckdb::LogicalType::INTEGER, duckdb::LogicalType::VARCHAR, duckdb::LogicalType::BIGINT,
+                    duckdb::LogicalType::BIGINT, duckdb::LogicalType::DOUBLE};
+    return duckdb::make_uniq<duckdb::TableFunctionData>();
+}
+
+duckdb::unique_ptr<duckdb::GlobalTableFunctionState>
+FlockmtlCascadeStats::Init(duckdb::ClientContext& context, duckdb::TableFunctionInitInput& input) {
+    auto state = duckdb::make_uniq<GlobalState>();
+    state->entries = CascadeStats::Snapshot();
+    return std::move(state);
+}
+
+void FlockmtlCascadeStats::Execute(duckdb::ClientContext& context, duckdb::TableFunctionInput& data,
+                                   duckdb::DataChunk& output) {
+    auto& state = data.global_state->Cast<GlobalState>();
+    idx_t count = 0;
+    while (state.offset < state.entries.size() && count < STANDARD_VECTOR_SIZE) {
+        const auto& entry = state.entries[state.offset++];
+        output.SetValue(0, count, duckdb::Value::INTEGER(entry.stage));
+        output.SetValue(1, count, duckdb::Value(entry.model));
+        output.SetValue(2, count, duckdb::Value::BIGINT(entry.rows));
+        output.SetValue(3, count, duckdb::Value::BIGINT(entry.escalated));
+        output.SetValue(4, count,
+                        duckdb::Value::DOUBLE(entry.rows > 0 ? static_cast<double>(entry.escalated) / entry.rows : 0));
+        count++;
+    }
+    output.SetCardinality(count);
+}
+
+} // namespace flockmtl
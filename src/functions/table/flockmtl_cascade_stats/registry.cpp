@@ -0,0 +1,12 @@
+#include "flockmtl/functions/table/flockmtl_cascade_stats.hpp"
+#include "flockmtl/registry/registry.hpp"
+
+namespace flockmtl {
+
+void TableRegistry::RegisterFlockmtlCascadeStats(duckdb::DatabaseInstance& db) {
+    duckdb::ExtensionUtil::RegisterFunction(
+        db, duckdb::TableFunction("flockmtl_cascade_stats", {}, FlockmtlCascadeStats::Execute,
+                                  FlockmtlCascadeStats::Bind, FlockmtlCascadeStats::Init));
+}
+
+} // namespace flockmtl
@@ -0,0 +1,47 @@
+#include "flockmtl/functions/table/flockmtl_prefilter_stats.hpp"
+
+#include <cmath>
+
+namespace flockmtl {
+
+duckdb::unique_ptr<duckdb::FunctionData> FlockmtlPrefilterStats::Bind(duckdb::ClientContext& context,
+                                                                      duckdb::TableFunctionBindInput& input,
+                                                                      duckdb::vector<duckdb::LogicalType>& return_types,
+                                                                      duckdb::vector<std::string>& names) {
+    names = {"embedding_model", "prompt", "cutoff", "sample_rows", "sample_selected",
+             "sample_recall", "sample_precision", "rows", "dropped"};
+    return_types = {duckdb::LogicalType::VARCHAR, duckdb::LogicalType::VARCHAR, duckdb::LogicalType::DOUBLE,
+                    duckdb::LogicalType::BIGINT,  duckdb::LogicalType::BIGINT,  duckdb::LogicalType::DOUBLE,
+                    duckdb::LogicalType::DOUBLE,  duckdb::LogicalType::BIGINT,  duckdb::LogicalType::BIGINT};
+    return duckdb::make_uniq<duckdb::TableFunctionData>();
+}
+
+duckdb::unique_ptr<duckdb::GlobalTableFunctionState>
+FlockmtlPrefilterStats::Init(duckdb::ClientContext& context, duckdb::TableFunctionInitInput& input) {
+    auto state = duckdb::make_uniq<GlobalState>();
+    state->entries = EmbeddingPrefilter::Snapshot();
+    return std::move(state);
+}
+
+void FlockmtlPrefilterStats::Execute(duckdb::ClientContext& context, duckdb::TableFunctionInput& data,
+                                     duckdb::DataChunk& output) {
+    auto& state = data.global_state->Cast<GlobalState>();
+    idx_t count = 0;
+    while (state.offset < state.entries.size() && count < STANDARD_VECTOR_SIZE) {
+        const auto& entry = state.entries[state.offset++];
+        output.SetValue(0, count, duckdb::Value(entry.embedding_model));
+        output.SetValue(1, count, duckdb::Value(entry.prompt));
+        // Uncalibrated, no sampled tuple matched
+        output.SetValue(2, count, std::isfinite(entry.cutoff) ? duckdb::Value::DOUBLE(entry.cutoff) : duckdb::Value());
+        output.SetValue(3, count, duckdb::Value::BIGINT(entry.sample_rows));
+        output.SetValue(4, count, duckdb::Value::BIGINT(entry.sample_selected));
+        output.SetValue(5, count, duckdb::Value::DOUBLE(entry.sample_recall));
+        output.SetValue(6, count, duckdb::Value::DOUBLE(entry.sample_precision));
+        output.SetValue(7, count, duckdb::Value::BIGINT(entry.rows));
+        output.SetValue(8, count, duckdb::Value::BIGINT(entry.dropped));
+        count++;
+    }
+    output.SetCardinality(count);
+}
+
+} // namespace flockmtl
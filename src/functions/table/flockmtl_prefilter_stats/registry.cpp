@@ -0,0 +1,12 @@
+#include "flockmtl/functions/table/flockmtl_prefilter_stats.hpp"
+#include "flockmtl/registry/registry.hpp"
+
+namespace flockmtl {
+
+void TableRegistry::RegisterFlockmtlPrefilterStats(duckdb::DatabaseInstance& db) {
+    duckdb::ExtensionUtil::RegisterFunction(
+        db, duckdb::TableFunction("flockmtl_prefilter_stats", {}, FlockmtlPrefilterStats::Execute,
+                                  FlockmtlPrefilterStats::Bind, FlockmtlPrefilterStats::Init));
+}
+
+} // namespace flockmtl
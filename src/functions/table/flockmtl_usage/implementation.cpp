@@ -0,0 +1,39 @@
+#include "flockmtl/functions/table/flockmtl_usage.hpp"
+
+namespace flockmtl {
+
+duckdb::unique_ptr<duckdb::FunctionData> FlockmtlUsage::Bind(duckdb::ClientContext& context,
+                                                             duckdb::TableFunctionBindInput& input,
+                                                             duckdb::vector<duckdb::LogicalType>& return_types,
+                                                             duckdb::vector<std::string>& names) {
+    names = {"provider", "model", "requests", "input_tokens", "cached_input_tokens", "output_tokens"};
+    return_types = {duckdb::LogicalType::VARCHAR, duckdb::LogicalType::VARCHAR, duckdb::LogicalType::BIGINT,
+                    duckdb::LogicalType::BIGINT,  duckdb::LogicalType::BIGINT,  duckdb::LogicalType::BIGINT};
+    return duckdb::make_uniq<duckdb::TableFunctionData>();
+}
+
+duckdb::unique_ptr<duckdb::GlobalTableFunctionState> FlockmtlUsage::Init(duckdb::ClientContext& context,
+                                                                         duckdb::TableFunctionInitInput& input) {
+    auto state = duckdb::make_uniq<GlobalState>();
+    state->entries = UsageStats::Snapshot();
+    return std::move(state);
+}
+
+void FlockmtlUsage::Execute(duckdb::ClientContext& context, duckdb::TableFunctionInput& data,
+                            duckdb::DataChunk& output) {
+    auto& state = data.global_state->Cast<GlobalState>();
+    idx_t count = 0;
+    while (state.offset < state.entries.size() && count < STANDARD_VECTOR_SIZE) {
+        const auto& entry = state.entries[state.offset++];
+        output.SetValue(0, count, duckdb::Value(entry.provider));
+        output.SetValue(1, count, duckdb::Value(entry.model));
+        output.SetValue(2, count, duckdb::Value::BIGINT(entry.usage.requests));
+        output.SetValue(3, count, duckdb::Value::BIGINT(entry.usage.input_tokens));
+        output.SetValue(4, count, duckdb::Value::BIGINT(entry.usage.cached_input_tokens));
+        output.SetValue(5, count, duckdb::Value::BIGINT(entry.usage.output_tokens));
+        count++;
+    }
+    output.SetCardinality(count);
+}
+
+} // namespace flockmtl
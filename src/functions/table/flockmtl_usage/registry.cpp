@@ -0,0 +1,11 @@
+#include "flockmtl/functions/table/flockmtl_usage.hpp"
+#include "flockmtl/registry/registry.hpp"
+
+namespace flockmtl {
+
+void TableRegistry::RegisterFlockmtlUsage(duckdb::DatabaseInstance& db) {
+    duckdb::ExtensionUtil::RegisterFunction(db, duckdb::TableFunction("flockmtl_usage", {}, FlockmtlUsage::Execute,
+                                                                      FlockmtlUsage::Bind, FlockmtlUsage::Init));
+}
+
+} // namespace flockmtl
@@ -27,6 +27,25 @@ public:
     static std::string get_prompts_table_name();
     constexpr static int32_t default_context_window = 128000;
     constexpr static int32_t default_max_output_tokens = 4096;
+    constexpr static int32_t default_connect_timeout = 30;
+    constexpr static int32_t default_request_timeout = 600;
+    constexpr static int32_t default_io_threads = 16;
+    constexpr static int32_t default_max_inflight_chunks = 16;
+    constexpr static int32_t default_max_retries = 2;
+    constexpr static double default_cascade_threshold = 0.8;
+    constexpr static int64_t default_embedding_cache_bytes = 256LL * 1024 * 1024;
+    constexpr static int32_t default_embedding_batch_size = 512;
+    constexpr static int64_t default_join_top_k = 5;
+    constexpr static int64_t default_cluster_count = 8;
+    constexpr static int32_t default_cluster_batch_size = 1024;
+    constexpr static int32_t default_cluster_iterations = 100;
+    constexpr static int32_t default_cluster_representatives = 5;
+    constexpr static int32_t default_prefilter_sample_size = 100;
+    constexpr static int32_t default_prefilter_min_matches = 10;
+    constexpr static int32_t default_prefilter_calibration_chunks = 10;
+    constexpr static int32_t default_prefilter_stats_size = 256;
+    constexpr static double default_prefilter_recall = 0.95;
+    constexpr static int64_t default_rerank_candidates = 100;
 
 private:
     static void SetupGlobalStorageLocation();
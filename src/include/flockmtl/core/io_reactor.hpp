@@ -0,0 +1,36 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace flockmtl {
+
+// Dedicated thread pool for blocking provider I/O, so DuckDB worker threads never wait on HTTP round trips.
+class IoReactor {
+public:
+    static IoReactor& Get();
+
+    // Tasks must not throw, they report their own errors. Queued tasks run before the reactor shuts down.
+    void Submit(std::function<void()> task);
+
+    IoReactor(const IoReactor&) = delete;
+    IoReactor& operator=(const IoReactor&) = delete;
+    ~IoReactor();
+
+private:
+    explicit IoReactor(int32_t num_threads);
+    void Run();
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> threads_;
+    bool stopping_ = false;
+};
+
+} // namespace flockmtl
@@ -68,6 +68,7 @@ private:
     void ParseDeleteModel(Tokenizer& tokenizer, std::unique_ptr<QueryStatement>& statement);
     void ParseUpdateModel(Tokenizer& tokenizer, std::unique_ptr<QueryStatement>& statement);
     void ParseGetModel(Tokenizer& tokenizer, std::unique_ptr<QueryStatement>& statement);
+    static void ValidateModelArgs(const nlohmann::json& model_args);
 };
 
 } // namespace flockmtl
@@ -4,18 +4,24 @@
 #include <nlohmann/json.hpp>
 
 #include "flockmtl/core/common.hpp"
+#include "flockmtl/functions/aggregate/aggregate_state.hpp"
 #include "flockmtl/model_manager/model.hpp"
 #include "flockmtl/functions/batch_response_builder.hpp"
 
 namespace flockmtl {
 
-class AggregateFunctionState {
+class AggregateFunctionBindData : public duckdb::FunctionData {
 public:
-    std::vector<nlohmann::json> value;
+    explicit AggregateFunctionBindData(duckdb::ClientContext& context) : context(context) {}
 
-    void Initialize();
-    void Update(const nlohmann::json& input);
-    void Combine(const AggregateFunctionState& source);
+    duckdb::ClientContext& context;
+
+    duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+        return duckdb::make_uniq<AggregateFunctionBindData>(context);
+    }
+    bool Equals(const duckdb::FunctionData& other) const override {
+        return &context == &other.Cast<AggregateFunctionBindData>().context;
+    }
 };
 
 class AggregateFunctionBase {
@@ -33,6 +39,13 @@ public:
     CastInputsToJson(duckdb::Vector inputs[], idx_t count);
 
     static bool IgnoreNull() { return true; };
+    // Tuples a group keeps at most, functions able to work on a sample of their group override it
+    static idx_t SampleSize(const duckdb::AggregateInputData& aggr_input_data) { return 0; }
+
+    static duckdb::unique_ptr<duckdb::FunctionData>
+    Bind(duckdb::ClientContext& context, duckdb::AggregateFunction& function,
+         duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments);
+    static void SetInterruptFlag(Model& model, const duckdb::AggregateInputData& aggr_input_data);
 
     template <class Derived>
     static void Initialize(const duckdb::AggregateFunction&, duckdb::data_ptr_t state_p) {
@@ -53,14 +66,17 @@ public:
         auto [model_details, prompt_details, tuples] = CastInputsToJson(inputs, count);
         auto function_instance = GetInstance<Derived>();
         function_instance->model = Model(model_details);
+        SetInterruptFlag(function_instance->model, aggr_input_data);
         function_instance->user_query = PromptManager::CreatePromptDetails(prompt_details).prompt;
 
+        const auto sample_size = Derived::SampleSize(aggr_input_data);
         auto states_vector = duckdb::FlatVector::GetData<AggregateFunctionState*>(states);
         for (idx_t i = 0; i < count; i++) {
             auto tuple = tuples[i];
             auto state_ptr = states_vector[i];
 
             auto state = function_instance->state_map[state_ptr];
+            state->sample_size = sample_size;
             state->Update(tuple);
         }
     }
@@ -73,12 +89,15 @@ public:
         auto [model_details, prompt_details, tuples] = CastInputsToJson(inputs, count);
         auto function_instance = GetInstance<Derived>();
         function_instance->model = Model(model_details);
+        SetInterruptFlag(function_instance->model, aggr_input_data);
         function_instance->user_query = PromptManager::CreatePromptDetails(prompt_details).prompt;
 
+        const auto sample_size = Derived::SampleSize(aggr_input_data);
         auto state_map_p = reinterpret_cast<AggregateFunctionState*>(state_p);
         for (idx_t i = 0; i < count; i++) {
             auto tuple = tuples[i];
             auto state = function_instance->state_map[state_map_p];
+            state->sample_size = sample_size;
             state->Update(tuple);
         }
     }
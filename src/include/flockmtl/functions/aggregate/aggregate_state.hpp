@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace flockmtl {
+
+// splitmix64, small enough to live in every aggregate state
+class SampleRandom {
+public:
+    using result_type = uint64_t;
+
+    //! 0 until the state draws for the first time, it is then seeded apart from the other states
+    uint64_t state = 0;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+    result_type operator()();
+    // Uniform in [0, bound)
+    uint64_t Below(uint64_t bound) { return (*this)() % bound; }
+};
+
+class AggregateFunctionState {
+public:
+    std::vector<nlohmann::json> value;
+    //! Tuples kept at most, 0 to keep all of them. Above it `value` is a uniform sample of the tuples seen.
+    uint64_t sample_size = 0;
+    //! Tuples the group received, `value` holds all of them unless it is sampled
+    uint64_t seen = 0;
+    SampleRandom random;
+
+    void Initialize();
+    void Update(const nlohmann::json& input);
+    void Combine(const AggregateFunctionState& source);
+};
+
+} // namespace flockmtl
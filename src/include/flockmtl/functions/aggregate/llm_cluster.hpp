@@ -0,0 +1,59 @@
+#pragma once
+
+#include "flockmtl/functions/aggregate/aggregate.hpp"
+
+namespace flockmtl {
+
+class LlmClusterBindData : public AggregateFunctionBindData {
+public:
+    LlmClusterBindData(duckdb::ClientContext& context, idx_t num_clusters)
+        : AggregateFunctionBindData(context), num_clusters(num_clusters) {}
+
+    idx_t num_clusters;
+
+    duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+        return duckdb::make_uniq<LlmClusterBindData>(context, num_clusters);
+    }
+    bool Equals(const duckdb::FunctionData& other) const override {
+        return AggregateFunctionBindData::Equals(other) &&
+               num_clusters == other.Cast<LlmClusterBindData>().num_clusters;
+    }
+};
+
+// Groups the tuples by topic: they are embedded, clustered with mini-batch k-means, and the model is called once per
+// cluster to name it from the tuples closest to its centroid.
+class LlmCluster : public AggregateFunctionBase {
+public:
+    explicit LlmCluster() = default;
+
+    // Cluster of every tuple, from unit-length embeddings of `dimensions` values each
+    static std::vector<idx_t> KMeans(const std::vector<float>& embeddings, idx_t dimensions, idx_t num_clusters,
+                                     std::vector<float>& centroids);
+    nlohmann::json LabelCluster(const std::vector<nlohmann::json>& representatives);
+    nlohmann::json Cluster(duckdb::ClientContext& context, const std::vector<nlohmann::json>& tuples,
+                           idx_t num_clusters);
+
+public:
+    static duckdb::unique_ptr<duckdb::FunctionData>
+    Bind(duckdb::ClientContext& context, duckdb::AggregateFunction& function,
+         duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments);
+    static void Initialize(const duckdb::AggregateFunction& function, duckdb::data_ptr_t state_p) {
+        AggregateFunctionBase::Initialize<LlmCluster>(function, state_p);
+    }
+    static void Operation(duckdb::Vector inputs[], duckdb::AggregateInputData& aggr_input_data, idx_t input_count,
+                          duckdb::Vector& states, idx_t count) {
+        AggregateFunctionBase::Operation<LlmCluster>(inputs, aggr_input_data, input_count, states, count);
+    }
+    static void SimpleUpdate(duckdb::Vector inputs[], duckdb::AggregateInputData& aggr_input_data, idx_t input_count,
+                             duckdb::data_ptr_t state_p, idx_t count) {
+        AggregateFunctionBase::SimpleUpdate<LlmCluster>(inputs, aggr_input_data, input_count, state_p, count);
+    }
+    static void Combine(duckdb::Vector& source, duckdb::Vector& target, duckdb::AggregateInputData& aggr_input_data,
+                        idx_t count) {
+        AggregateFunctionBase::Combine<LlmCluster>(source, target, aggr_input_data, count);
+    }
+    static void Finalize(duckdb::Vector& states, duckdb::AggregateInputData& aggr_input_data, duckdb::Vector& result,
+                         idx_t count, idx_t offset);
+};
+
+} // namespace flockmtl
@@ -4,6 +4,22 @@
 
 namespace flockmtl {
 
+class LlmReduceBindData : public AggregateFunctionBindData {
+public:
+    LlmReduceBindData(duckdb::ClientContext& context, idx_t sample_size)
+        : AggregateFunctionBindData(context), sample_size(sample_size) {}
+
+    //! Tuples a group keeps at most, 0 to reduce all of them
+    idx_t sample_size;
+
+    duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+        return duckdb::make_uniq<LlmReduceBindData>(context, sample_size);
+    }
+    bool Equals(const duckdb::FunctionData& other) const override {
+        return AggregateFunctionBindData::Equals(other) && sample_size == other.Cast<LlmReduceBindData>().sample_size;
+    }
+};
+
 class LlmReduce : public AggregateFunctionBase {
 public:
     explicit LlmReduce() = default;
@@ -13,6 +29,11 @@ public:
     nlohmann::json ReduceLoop(const std::vector<nlohmann::json>& tuples, const AggregateFunctionType& function_type);
 
 public:
+    static duckdb::unique_ptr<duckdb::FunctionData>
+    Bind(duckdb::ClientContext& context, duckdb::AggregateFunction& function,
+         duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments);
+    // The optional sample size argument: above it a group is reduced over a uniform sample of its tuples
+    static idx_t SampleSize(const duckdb::AggregateInputData& aggr_input_data);
     static void Initialize(const duckdb::AggregateFunction& function, duckdb::data_ptr_t state_p) {
         AggregateFunctionBase::Initialize<LlmReduce>(function, state_p);
     }
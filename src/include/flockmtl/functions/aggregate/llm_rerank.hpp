@@ -9,6 +9,9 @@ public:
     explicit LlmRerank() = default;
 
     int GetAvailableTokens();
+    // Keeps the flockmtl_rerank_candidates tuples closest to the prompt by embedding similarity, so only those go
+    // through the window passes. Unchanged unless flockmtl_rerank_embedding_model is set.
+    nlohmann::json PruneCandidates(duckdb::ClientContext& context, const nlohmann::json& tuples);
     nlohmann::json SlidingWindow(nlohmann::json& tuples);
     std::vector<int> RerankBatch(const nlohmann::json& tuples);
 
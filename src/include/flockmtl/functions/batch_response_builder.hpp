@@ -9,4 +9,22 @@ namespace flockmtl {
 
 std::vector<nlohmann::json> CastVectorOfStructsToJson(const duckdb::Vector& struct_vector, int size);
 
+// Distinct tuples of a struct vector and, for every row, the index of its tuple.
+struct DistinctTuples {
+    std::vector<nlohmann::json> tuples;
+    std::vector<idx_t> row_to_tuple;
+};
+
+DistinctTuples CastVectorOfStructsToDistinctJson(duckdb::Vector& struct_vector, int size);
+
+// JSON schema accepted by the providers' structured outputs for values of a DuckDB type.
+nlohmann::json JsonSchemaFromType(const duckdb::LogicalType& type);
+
+// Writes a JSON value into a row of a flat vector, recursing into the child vectors of structs.
+void WriteJsonToVector(const nlohmann::json& json, duckdb::Vector& vector, idx_t row);
+
+// Writes one response per distinct tuple into every row holding that tuple, as serialized JSON. Each response is
+// serialized and copied into the vector's string heap once, rows sharing a tuple share the string.
+void WriteResponses(const nlohmann::json& responses, const DistinctTuples& distinct, duckdb::Vector& result);
+
 } // namespace flockmtl
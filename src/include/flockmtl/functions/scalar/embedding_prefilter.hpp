@@ -0,0 +1,60 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+
+#include "flockmtl/functions/scalar/scalar.hpp"
+
+namespace flockmtl {
+
+// Drops the tuples an llm_filter prompt is obviously irrelevant to before they reach the model. The prompt and the
+// tuples are embedded with the model named by the flockmtl_prefilter_model setting, and the tuples whose cosine
+// similarity to the prompt falls below a cutoff are rejected. The cutoff is calibrated once per query and prompt on
+// samples of the first chunks the model answers, as the lowest similarity keeping flockmtl_prefilter_recall of the
+// sampled matches. Every tuple is kept until enough matches were sampled.
+class EmbeddingPrefilter {
+public:
+    // Calibration and effect of the pre-filter for one embedding model and prompt, accumulated since the extension
+    // was loaded. The sample figures are those of the latest calibration. Only the most recently used prompts are
+    // kept.
+    struct Entry {
+        std::string embedding_model;
+        std::string prompt;
+        double cutoff = 0;
+        int64_t sample_rows = 0;
+        int64_t sample_selected = 0;
+        double sample_recall = 1;
+        double sample_precision = 0;
+        int64_t rows = 0;
+        int64_t dropped = 0;
+    };
+
+    static bool IsEnabled(duckdb::ClientContext& context);
+    // Whether each tuple goes on to the model, the others do not satisfy the prompt
+    static std::vector<bool> Apply(duckdb::ClientContext& context, const std::vector<nlohmann::json>& tuples,
+                                   const std::string& user_prompt, ScalarFunctionType function_type, double threshold,
+                                   Model& model);
+    static std::vector<Entry> Snapshot();
+
+private:
+    // Similarities of the tuples sampled from one chunk, and of those the model selected
+    struct Sample {
+        std::vector<double> similarities;
+        std::vector<double> matches;
+    };
+
+    static Sample SampleChunk(duckdb::ClientContext& context, const std::vector<nlohmann::json>& tuples,
+                              const std::vector<double>& similarities, const std::string& user_prompt,
+                              ScalarFunctionType function_type, double threshold, Model& model);
+    static double Calibrate(duckdb::ClientContext& context, const Sample& sample, const std::string& embedding_model,
+                            const std::string& user_prompt);
+    // Must be called with mutex_ held, evicts the least recently used prompt when the statistics are full
+    static Entry& GetEntry(const std::string& embedding_model, const std::string& user_prompt);
+
+    static std::mutex mutex_;
+    static uint64_t clock_;
+    //! Entries with the clock_ value of their latest use
+    static std::map<std::pair<std::string, std::string>, std::pair<Entry, uint64_t>> entries_;
+};
+
+} // namespace flockmtl
@@ -7,7 +7,7 @@ namespace flockmtl {
 class LlmComplete : public ScalarFunctionBase {
 public:
     static void ValidateArguments(duckdb::DataChunk& args);
-    static std::vector<std::string> Operation(duckdb::DataChunk& args);
+    static void Operation(duckdb::DataChunk& args, duckdb::ClientContext& context, duckdb::Vector& result);
     static void Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result);
 };
 
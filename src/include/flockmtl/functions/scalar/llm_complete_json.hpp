@@ -7,7 +7,12 @@ namespace flockmtl {
 class LlmCompleteJson : public ScalarFunctionBase {
 public:
     static void ValidateArguments(duckdb::DataChunk& args);
-    static std::vector<std::string> Operation(duckdb::DataChunk& args);
+    // Returns the STRUCT given as the fourth argument, either as a typed value or as a type name, instead of JSON.
+    // Rejects models with a cascade.
+    static duckdb::unique_ptr<duckdb::FunctionData>
+    Bind(duckdb::ClientContext& context, duckdb::ScalarFunction& bound_function,
+         duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments);
+    static void Operation(duckdb::DataChunk& args, duckdb::ClientContext& context, duckdb::Vector& result);
     static void Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result);
 };
 
@@ -6,8 +6,19 @@ namespace flockmtl {
 
 class LlmFilter : public ScalarFunctionBase {
 public:
+    static constexpr double DEFAULT_THRESHOLD = 0.5;
+
     static void ValidateArguments(duckdb::DataChunk& args);
-    static std::vector<std::string> Operation(duckdb::DataChunk& args);
+    // The threshold applies to the whole call, so it must be a constant
+    static duckdb::unique_ptr<duckdb::FunctionData>
+    Bind(duckdb::ClientContext& context, duckdb::ScalarFunction& bound_function,
+         duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& arguments);
+    // FILTER_SCORE when a threshold is given, otherwise FILTER_IDS unless the flockmtl_filter_ids setting is off
+    static ScalarFunctionType GetFunctionType(duckdb::ClientContext& context, bool has_threshold);
+    static double GetThreshold(const duckdb::Value& threshold);
+    // Whether a response, a boolean or a confidence score, selects its tuple
+    static bool IsSelected(const nlohmann::json& response, double threshold);
+    static std::vector<bool> Operation(duckdb::DataChunk& args, duckdb::ClientContext& context);
     static void Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result);
 };
 
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "flockmtl/functions/scalar/scalar.hpp"
+
+namespace flockmtl {
+
+class LlmFilterScore : public ScalarFunctionBase {
+public:
+    static void ValidateArguments(duckdb::DataChunk& args);
+    // The probability the model gives to the filter holding, from the token log probabilities of its answer
+    static double GetScore(const nlohmann::json& response);
+    static std::vector<double> Operation(duckdb::DataChunk& args, duckdb::ClientContext& context);
+    static void Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result);
+};
+
+} // namespace flockmtl
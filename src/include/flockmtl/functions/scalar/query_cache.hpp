@@ -0,0 +1,34 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+#include "flockmtl/core/common.hpp"
+
+namespace flockmtl {
+
+// Responses of calls whose inputs are the same for the whole query (e.g. tuple-less llm_complete). Concurrent
+// requests for the same key wait on the first one instead of issuing their own call; cleared when the query ends.
+class QueryCache : public duckdb::ClientContextState {
+public:
+    static QueryCache& Get(duckdb::ClientContext& context);
+
+    nlohmann::json GetOrCompute(const std::string& key, const std::function<nlohmann::json()>& compute);
+
+    // Answers of single tuples, so a call appearing in several places of a plan (e.g. in the WHERE clause and the
+    // SELECT list) reaches the model once per tuple.
+    bool LookupTuple(const std::string& key, nlohmann::json& response);
+    void StoreTuple(const std::string& key, const nlohmann::json& response);
+
+    void QueryEnd() override;
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_future<nlohmann::json>> responses_;
+    std::unordered_map<std::string, nlohmann::json> tuple_responses_;
+};
+
+} // namespace flockmtl
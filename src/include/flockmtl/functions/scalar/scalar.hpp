@@ -8,6 +8,7 @@
 #include "flockmtl/model_manager/tiktoken.hpp"
 #include "flockmtl/prompt_manager/prompt_manager.hpp"
 #include "flockmtl/functions/batch_response_builder.hpp"
+#include "flockmtl/functions/scalar/query_cache.hpp"
 
 namespace flockmtl {
 
@@ -19,11 +20,27 @@ public:
     static std::vector<std::any> Operation(duckdb::DataChunk& args);
     static void Execute(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result);
 
-    static nlohmann::json Complete(const nlohmann::json& tuples, const std::string& user_prompt,
-                                   ScalarFunctionType function_type, Model& model);
+    // Answers of one batch, aligned with its tuples
+    struct CompletedBatch {
+        std::vector<nlohmann::json> responses;
+        std::vector<bool> answered;
+        //! The output hit max_output_tokens, only the answers complete before the cut are kept
+        bool truncated = false;
+        size_t output_tokens = 0;
+    };
+
+    static CompletedBatch Complete(const nlohmann::json& tuples, const std::string& user_prompt,
+                                   ScalarFunctionType function_type, Model& model,
+                                   const CompletionOptions& options = {});
+    // Tuples already answered for the same model, prompt and function in this query are taken from `cache`
     static nlohmann::json BatchAndComplete(const std::vector<nlohmann::json>& tuples,
                                            const std::string& user_prompt_name, ScalarFunctionType function_type,
-                                           Model& model);
+                                           Model& model, QueryCache* cache = nullptr,
+                                           const CompletionOptions& options = {});
+    // Runs the model's cascade: every stage answers with a confidence, only the tuples it is not confident about
+    // are sent to the next one. Filters answer with their score, completions with their text.
+    static nlohmann::json CascadeAndComplete(const std::vector<nlohmann::json>& tuples, const std::string& user_prompt,
+                                             ScalarFunctionType function_type, Model& model, QueryCache* cache);
 };
 
 } // namespace flockmtl
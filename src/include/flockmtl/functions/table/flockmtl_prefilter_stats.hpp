@@ -0,0 +1,25 @@
+#pragma once
+
+#include "flockmtl/core/common.hpp"
+#include "flockmtl/functions/scalar/embedding_prefilter.hpp"
+#include "duckdb/function/table_function.hpp"
+
+namespace flockmtl {
+
+class FlockmtlPrefilterStats {
+public:
+    struct GlobalState : public duckdb::GlobalTableFunctionState {
+        std::vector<EmbeddingPrefilter::Entry> entries;
+        idx_t offset = 0;
+    };
+
+    static duckdb::unique_ptr<duckdb::FunctionData> Bind(duckdb::ClientContext& context,
+                                                         duckdb::TableFunctionBindInput& input,
+                                                         duckdb::vector<duckdb::LogicalType>& return_types,
+                                                         duckdb::vector<std::string>& names);
+    static duckdb::unique_ptr<duckdb::GlobalTableFunctionState> Init(duckdb::ClientContext& context,
+                                                                     duckdb::TableFunctionInitInput& input);
+    static void Execute(duckdb::ClientContext& context, duckdb::TableFunctionInput& data, duckdb::DataChunk& output);
+};
+
+} // namespace flockmtl
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace flockmtl {
+
+// Rows answered and escalated by each stage of model cascades, accumulated since the extension was loaded.
+class CascadeStats {
+public:
+    struct Entry {
+        int32_t stage;
+        std::string model;
+        int64_t rows = 0;
+        int64_t escalated = 0;
+    };
+
+    static void Record(int32_t stage, const std::string& model, int64_t rows, int64_t escalated);
+    static std::vector<Entry> Snapshot();
+
+private:
+    static std::mutex mutex_;
+    static std::map<std::pair<int32_t, std::string>, Entry> stages_;
+};
+
+} // namespace flockmtl
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flockmtl/model_manager/model.hpp"
+
+namespace flockmtl {
+
+// Process-wide cache of text embeddings, so rows embedded by one query are not sent again by the next. Embeddings
+// are kept in single precision, and the oldest entries are evicted once the cache holds more than its capacity in
+// bytes, set with the flockmtl_embedding_cache_size setting.
+class EmbeddingCache {
+public:
+    static EmbeddingCache& Get();
+
+    // One embedding per text, only the texts not cached for the model's provider and model are sent to it
+    std::vector<std::vector<float>> Embed(Model& model, const std::vector<std::string>& texts);
+    // Cosine similarity of each tuple to `text`
+    std::vector<double> Similarities(Model& model, const std::string& text, const std::vector<nlohmann::json>& tuples);
+
+    // The text llm_embedding embeds for a tuple
+    static std::string TupleText(const nlohmann::json& tuple);
+    static double CosineSimilarity(const std::vector<float>& lhs, const std::vector<float>& rhs);
+
+    void SetCapacity(idx_t capacity_bytes);
+
+private:
+    void Store(const std::string& key, std::vector<float> embedding);
+    // Must hold the lock.
+    void Evict();
+    static idx_t EntryBytes(const std::string& key, const std::vector<float>& embedding);
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::vector<float>> embeddings_;
+    std::deque<std::string> insertion_order_;
+    idx_t capacity_bytes_ = Config::default_embedding_cache_bytes;
+    idx_t bytes_ = 0;
+};
+
+} // namespace flockmtl
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <tuple>
+#include <atomic>
 #include <vector>
+#include <functional>
 #include <string>
 #include <utility>
 #include <nlohmann/json.hpp>
@@ -22,15 +24,33 @@ public:
     explicit Model(const nlohmann::json& model_json);
     explicit Model() = default;
     nlohmann::json CallComplete(const std::string& prompt, const bool json_response = true);
+    nlohmann::json CallComplete(const PromptMessages& prompt, const bool json_response = true,
+                                const CompletionOptions& options = {});
     nlohmann::json CallEmbedding(const std::vector<std::string>& inputs);
     ModelDetails GetModelDetails();
+    void SetAbortCheck(std::function<bool()> abort_check);
+    void SetInterruptFlag(const std::atomic<bool>& interrupted);
+    // The next model of a cascade, with this model's settings and abort check
+    Model Escalate(const std::string& model_name) const;
+    // This model as a single stage of its cascade
+    Model WithoutCascade() const;
+    // The cascade the model settings name, from the settings or the stored model, without resolving the secret
+    static std::vector<std::string> GetCascade(const nlohmann::json& model_json);
 
 private:
     std::shared_ptr<IProvider> provider_;
     ModelDetails model_details_;
+    //! The settings the model was built from, escalated models keep them
+    nlohmann::json model_json_;
+    std::function<bool()> abort_check_;
     void ConstructProvider();
     void LoadModelDetails(const nlohmann::json& model_json);
-    std::tuple<std::string, std::string, int32_t, int32_t> GetQueriedModel(const std::string& model_name);
+    static int ParseSeconds(const std::string& key, const nlohmann::json& value);
+    static std::vector<std::string> ParseCascade(const nlohmann::json& cascade);
+    void ThrowIfAborted();
+    // Identifies a completion request for SingleFlight
+    std::string RequestKey(const PromptMessages& prompt, bool json_response, const CompletionOptions& options) const;
+    static std::tuple<std::string, std::string, nlohmann::json> GetQueriedModel(const std::string& model_name);
     std::string GetSecret(const std::string& secret_name);
 };
 
@@ -9,7 +9,8 @@ class OllamaProvider : public IProvider {
 public:
     OllamaProvider(const ModelDetails &model_details) : IProvider(model_details) {}
 
-    nlohmann::json CallComplete(const std::string &prompt, bool json_response) override;
+    nlohmann::json CallComplete(const PromptMessages &prompt, bool json_response,
+                                const CompletionOptions &options) override;
     nlohmann::json CallEmbedding(const std::vector<std::string> &inputs) override;
 };
 
@@ -23,6 +23,12 @@ public:
     AzureModelManager(AzureModelManager&&) = delete;
     AzureModelManager& operator=(AzureModelManager&&) = delete;
 
+    void SetTimeouts(long connect_timeout, long request_timeout) {
+        _session.setTimeouts(connect_timeout, request_timeout);
+    }
+
+    void SetAbortCheck(std::function<bool()> abort_check) { _session.setAbortCheck(std::move(abort_check)); }
+
     nlohmann::json CallComplete(const nlohmann::json& json, const std::string& contentType = "application/json") {
         std::string url = "https://" + _resource_name + ".openai.azure.com/openai/deployments/" +
                           _deployment_model_name + "/chat/completions?api-version=" + _api_version;
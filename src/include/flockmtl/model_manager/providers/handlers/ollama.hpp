@@ -19,6 +19,12 @@ public:
     OllamaModelManager(OllamaModelManager&&) = delete;
     OllamaModelManager& operator=(OllamaModelManager&&) = delete;
 
+    void SetTimeouts(long connect_timeout, long request_timeout) {
+        _session.setTimeouts(connect_timeout, request_timeout);
+    }
+
+    void SetAbortCheck(std::function<bool()> abort_check) { _session.setAbortCheck(std::move(abort_check)); }
+
     std::string GetChatUrl() const { return _url + "/api/generate"; }
 
     std::string GetEmbedUrl() const { return _url + "/api/embeddings"; }
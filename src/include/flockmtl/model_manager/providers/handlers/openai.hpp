@@ -291,6 +291,12 @@ public:
 
     void setBeta(const std::string &beta) { session_.setBeta(beta); }
 
+    void setTimeouts(long connect_timeout, long request_timeout) {
+        session_.setTimeouts(connect_timeout, request_timeout);
+    }
+
+    void setAbortCheck(std::function<bool()> abort_check) { session_.setAbortCheck(std::move(abort_check)); }
+
     // void change_token(const std::string& token) { token_ = token; };
     void setThrowException(bool throw_exception) { throw_exception_ = throw_exception; }
 
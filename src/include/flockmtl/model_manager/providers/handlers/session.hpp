@@ -1,6 +1,7 @@
 #pragma once
 
 #include <curl/curl.h>
+#include <functional>
 #include <mutex>
 #include <string>
 #include <stdexcept>
@@ -61,6 +62,20 @@ public:
 
     void setBeta(const std::string &beta) { beta_ = beta; }
 
+    // Timeouts are in seconds, 0 disables the corresponding limit.
+    void setTimeouts(long connect_timeout, long request_timeout) {
+        curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT, connect_timeout);
+        curl_easy_setopt(curl_, CURLOPT_TIMEOUT, request_timeout);
+    }
+
+    // The check is polled by curl while a transfer is in flight; returning true aborts it.
+    void setAbortCheck(std::function<bool()> abort_check) {
+        abort_check_ = std::move(abort_check);
+        curl_easy_setopt(curl_, CURLOPT_XFERINFOFUNCTION, xferinfoFunction);
+        curl_easy_setopt(curl_, CURLOPT_XFERINFODATA, this);
+        curl_easy_setopt(curl_, CURLOPT_NOPROGRESS, abort_check_ ? 0L : 1L);
+    }
+
     void setBody(const std::string &data);
     void setMultiformPart(const std::pair<std::string, std::string> &filefield_and_filepath,
                           const std::map<std::string, std::string> &fields);
@@ -80,6 +95,11 @@ private:
         return size * nmemb;
     }
 
+    static int xferinfoFunction(void *clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+        auto session = static_cast<Session *>(clientp);
+        return session->abort_check_ && session->abort_check_() ? 1 : 0;
+    }
+
 private:
     CURL *curl_;
     CURLcode res_;
@@ -90,6 +110,7 @@ private:
     std::string organization_;
     std::string beta_;
     std::string provider_;
+    std::function<bool()> abort_check_;
 
     bool throw_exception_;
     std::mutex mutex_request_;
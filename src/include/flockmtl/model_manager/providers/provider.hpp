@@ -1,25 +1,46 @@
 #pragma once
 
+#include <functional>
 #include <nlohmann/json.hpp>
 #include "fmt/format.h"
 
 #include "flockmtl/model_manager/repository.hpp"
+#include "flockmtl/model_manager/response_parser.hpp"
+#include "flockmtl/model_manager/usage_stats.hpp"
 
 namespace flockmtl {
 
 class IProvider {
 public:
     ModelDetails model_details_;
+    std::function<bool()> abort_check_;
+
+    static constexpr auto PROBABILITIES_KEY = "flockmtl_probabilities";
+    static constexpr int TOP_LOGPROBS = 5;
 
     explicit IProvider(const ModelDetails& model_details) : model_details_(model_details) {};
     virtual ~IProvider() = default;
 
-    virtual nlohmann::json CallComplete(const std::string& prompt, bool json_response) = 0;
+    virtual nlohmann::json CallComplete(const PromptMessages& prompt, bool json_response,
+                                        const CompletionOptions& options) = 0;
     virtual nlohmann::json CallEmbedding(const std::vector<std::string>& inputs) = 0;
+
+protected:
+    static void AttachProbabilities(nlohmann::json& response, const nlohmann::json& token_logprobs) {
+        if (response.is_object() && token_logprobs.is_array()) {
+            response[PROBABILITIES_KEY] = ResponseParser::ValueProbabilities(token_logprobs);
+        }
+    }
 };
 
 class ExceededMaxOutputTokensError : public std::exception {
 public:
+    ExceededMaxOutputTokensError() = default;
+    explicit ExceededMaxOutputTokensError(std::string partial_content) : partial_content(std::move(partial_content)) {}
+
+    //! What the model generated before it was cut, complete elements can still be salvaged from it
+    std::string partial_content;
+
     const char* what() const noexcept override {
         return "The response exceeded the max_output_tokens length; increase your max_output_tokens parameter.";
     }
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <algorithm>
+#include <nlohmann/json.hpp>
+
+#include "flockmtl/prompt_manager/repository.hpp"
 
 namespace flockmtl {
 
@@ -11,8 +15,23 @@ struct ModelDetails {
     std::string model;
     int32_t context_window;
     int32_t max_output_tokens;
+    int32_t connect_timeout;
+    int32_t request_timeout;
     float temperature;
+    TupleFormat tuple_format;
     std::unordered_map<std::string, std::string> secret;
+    //! Models that rows are escalated to, in order, when this one is not confident enough
+    std::vector<std::string> cascade;
+    double cascade_threshold;
+};
+
+// Settings of a single completion request. Copies of a model share their provider, so anything that differs
+// between the calls of a model travels with the request.
+struct CompletionOptions {
+    //! JSON schema the completion must follow, null to only ask for JSON
+    nlohmann::json response_schema;
+    //! Ask for token log probabilities, JSON completions then carry the probability of each response value
+    bool logprobs = false;
 };
 
 const std::string OLLAMA = "ollama";
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace flockmtl {
+
+class ResponseParser {
+public:
+    // Parses a JSON completion, ignoring a markdown code fence around it. Output cut short by the token limit
+    // keeps its complete elements: the unfinished one is dropped and the open containers are closed.
+    static nlohmann::json Parse(const std::string& content);
+
+    // Probability of every "response" value of a completion, in order, from the token log probabilities reported
+    // with it (a list of {token, logprob, top_logprobs}). Booleans get the probability of true against false,
+    // other values the probability of their first token.
+    static nlohmann::json ValueProbabilities(const nlohmann::json& token_logprobs);
+
+    // Where the answer of a tuple is in the "tuples" list of a completion
+    struct AnswerIndex {
+        //! Position of the answer in the list, -1 when the tuple was not answered
+        int64_t answer = -1;
+        //! Position of its value among the "response" values of the completion
+        size_t value = 0;
+    };
+
+    // Matches the answers of a batch of `num_tuples` tuples to them by id, so a dropped or merged row leaves its tuple
+    // unanswered instead of shifting the others. Answers without ids are taken in order only when `complete` and
+    // there is one per tuple.
+    static std::vector<AnswerIndex> MatchAnswers(const nlohmann::json& answers, size_t num_tuples, bool complete);
+    // Maps the ids returned under the FILTER_IDS protocol back to one boolean per tuple
+    static nlohmann::json IdsToBooleans(const nlohmann::json& ids, size_t num_tuples);
+    // Returns -1 for anything that is not a tuple id
+    static int64_t ParseTupleId(const nlohmann::json& id);
+
+private:
+    static std::string StripCodeFence(const std::string& content);
+    static bool TryRepairTruncated(const std::string& content, nlohmann::json& repaired);
+    static double BooleanProbability(const nlohmann::json& token_logprob, bool chosen);
+};
+
+} // namespace flockmtl
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+namespace flockmtl {
+
+// Process-wide registry of outstanding provider requests. Identical requests issued while one is in flight, from
+// any connection, wait for its response instead of sending their own. Nothing is kept once a request completes.
+class SingleFlight {
+public:
+    static SingleFlight& Get();
+
+    // Runs `call` unless a request with the same key is outstanding, in which case its response (or error) is shared.
+    // `check_abort` is polled while waiting and throws to give up on the shared request.
+    nlohmann::json Do(const std::string& key, const std::function<nlohmann::json()>& call,
+                      const std::function<void()>& check_abort);
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_future<nlohmann::json>> inflight_;
+};
+
+} // namespace flockmtl
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "flockmtl/model_manager/repository.hpp"
+
+namespace flockmtl {
+
+struct TokenUsage {
+    int64_t requests = 0;
+    int64_t input_tokens = 0;
+    int64_t cached_input_tokens = 0;
+    int64_t output_tokens = 0;
+};
+
+// Token usage reported by the providers, accumulated per provider and model since the extension was loaded.
+class UsageStats {
+public:
+    struct Entry {
+        std::string provider;
+        std::string model;
+        TokenUsage usage;
+    };
+
+    static void Record(const ModelDetails& model_details, const TokenUsage& usage);
+    // Reads the `usage` object of an OpenAI compatible chat completion response
+    static TokenUsage FromChatCompletion(const nlohmann::json& completion);
+    static std::vector<Entry> Snapshot();
+
+private:
+    static std::mutex mutex_;
+    static std::map<std::pair<std::string, std::string>, TokenUsage> usage_;
+};
+
+} // namespace flockmtl
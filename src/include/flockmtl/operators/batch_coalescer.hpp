@@ -0,0 +1,45 @@
+#pragma once
+
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+#include "flockmtl/core/common.hpp"
+#include "flockmtl/functions/scalar/query_cache.hpp"
+#include "flockmtl/model_manager/model.hpp"
+#include "flockmtl/prompt_manager/prompt_manager.hpp"
+
+namespace flockmtl {
+
+// Packs the tuples of one (model, prompt, function) call site, across every chunk and thread of a query, into
+// prompts filled up to the model's context window. Not thread safe, the owner serializes Add and Flush.
+class BatchCoalescer {
+public:
+    struct Batch {
+        std::vector<nlohmann::json> tuples;
+        //! Caller-defined handles of the rows holding each tuple, used to route the responses back
+        std::vector<std::vector<idx_t>> tickets;
+    };
+
+    BatchCoalescer(Model model, std::string user_prompt, ScalarFunctionType function_type,
+                   QueryCache* cache = nullptr);
+
+    // Returns true and moves the pending batch into full_batch when the tuple does not fit next to it. A tuple
+    // already pending is not sent twice, its tickets join the existing entry.
+    bool Add(nlohmann::json tuple, std::vector<idx_t> tickets, Batch& full_batch);
+    bool Flush(Batch& batch);
+
+    // Sends a batch to the model, returns one response per tuple.
+    std::vector<nlohmann::json> Complete(const Batch& batch) const;
+
+private:
+    Model model_;
+    std::string user_prompt_;
+    ScalarFunctionType function_type_;
+    QueryCache* cache_;
+    unsigned available_tokens_;
+    BatchTokenCounter pending_tokens_;
+    Batch pending_;
+    std::unordered_map<std::string, idx_t> pending_index_;
+};
+
+} // namespace flockmtl
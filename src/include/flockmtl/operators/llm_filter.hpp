@@ -0,0 +1,54 @@
+#pragma once
+
+#include "flockmtl/core/common.hpp"
+#include "duckdb/execution/physical_operator.hpp"
+#include "duckdb/planner/operator/logical_extension_operator.hpp"
+
+namespace flockmtl {
+
+// Filter holding an llm_filter predicate below a constant LIMIT, stops calling the model once enough rows passed.
+class LogicalLlmFilter : public duckdb::LogicalExtensionOperator {
+public:
+    LogicalLlmFilter(duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> expressions, idx_t limit);
+
+    //! Rows the operators above need, the LIMIT plus its OFFSET
+    idx_t limit;
+
+public:
+    duckdb::unique_ptr<duckdb::PhysicalOperator> CreatePlan(duckdb::ClientContext& context,
+                                                            duckdb::PhysicalPlanGenerator& generator) override;
+    duckdb::vector<duckdb::ColumnBinding> GetColumnBindings() override;
+    std::string GetExtensionName() const override { return "flockmtl"; }
+    std::string GetName() const override { return "LLM_FILTER"; }
+
+protected:
+    void ResolveTypes() override;
+};
+
+// Streaming filter: the cheap conjuncts run first, then the remaining rows are sent to the model one prompt at a
+// time. Once `limit` rows passed across all threads no further prompt is sent and the requests in flight are aborted.
+class PhysicalLlmFilter : public duckdb::PhysicalOperator {
+public:
+    PhysicalLlmFilter(duckdb::vector<duckdb::LogicalType> types,
+                      duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> expressions, idx_t limit,
+                      idx_t estimated_cardinality);
+
+    //! The llm_filter call
+    duckdb::unique_ptr<duckdb::Expression> llm_filter;
+    //! The other conjuncts, nullptr when there are none
+    duckdb::unique_ptr<duckdb::Expression> predicate;
+    idx_t limit;
+
+public:
+    duckdb::unique_ptr<duckdb::GlobalOperatorState>
+    GetGlobalOperatorState(duckdb::ClientContext& context) const override;
+    duckdb::unique_ptr<duckdb::OperatorState> GetOperatorState(duckdb::ExecutionContext& context) const override;
+    duckdb::OperatorResultType Execute(duckdb::ExecutionContext& context, duckdb::DataChunk& input,
+                                       duckdb::DataChunk& chunk, duckdb::GlobalOperatorState& gstate,
+                                       duckdb::OperatorState& state) const override;
+    bool ParallelOperator() const override { return true; }
+
+    std::string GetName() const override { return "LLM_FILTER"; }
+};
+
+} // namespace flockmtl
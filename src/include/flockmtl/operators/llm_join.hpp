@@ -0,0 +1,79 @@
+#pragma once
+
+#include "flockmtl/core/common.hpp"
+#include "duckdb/execution/operator/join/physical_join.hpp"
+#include "duckdb/planner/operator/logical_extension_operator.hpp"
+
+namespace flockmtl {
+
+// Inner join on an llm_filter predicate whose input struct has fields from both sides. Instead of sending every pair
+// to the model, each left row is only paired with the `top_k` right rows closest to it by embedding similarity.
+class LogicalLlmJoin : public duckdb::LogicalExtensionOperator {
+public:
+    //! `expressions` holds the model and the prompt of the llm_filter call
+    LogicalLlmJoin(duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> expressions, std::string embedding_model,
+                   idx_t top_k);
+
+    //! Fields of the llm_filter input struct computed from each side, with their names in the struct
+    duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> left_inputs;
+    duckdb::vector<std::string> left_names;
+    duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> right_inputs;
+    duckdb::vector<std::string> right_names;
+    std::string embedding_model;
+    idx_t top_k;
+
+public:
+    duckdb::unique_ptr<duckdb::PhysicalOperator> CreatePlan(duckdb::ClientContext& context,
+                                                            duckdb::PhysicalPlanGenerator& generator) override;
+    duckdb::vector<duckdb::ColumnBinding> GetColumnBindings() override;
+    std::string GetExtensionName() const override { return "flockmtl"; }
+    std::string GetName() const override { return "LLM_JOIN"; }
+
+protected:
+    void ResolveTypes() override;
+};
+
+// The right side is materialized and embedded by the sink. Each left chunk is embedded, its candidate pairs are
+// blocked by similarity and sent to the model in batches, and the pairs it accepts are emitted.
+class PhysicalLlmJoin : public duckdb::PhysicalJoin {
+public:
+    PhysicalLlmJoin(LogicalLlmJoin& op, duckdb::unique_ptr<duckdb::PhysicalOperator> left,
+                    duckdb::unique_ptr<duckdb::PhysicalOperator> right, idx_t estimated_cardinality);
+
+    duckdb::unique_ptr<duckdb::Expression> model;
+    duckdb::unique_ptr<duckdb::Expression> prompt;
+    //! The inputs of both sides, their column references resolved against their own side
+    duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> left_inputs;
+    duckdb::vector<std::string> left_names;
+    duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> right_inputs;
+    duckdb::vector<std::string> right_names;
+    std::string embedding_model;
+    idx_t top_k;
+
+public:
+    // Operator interface
+    duckdb::unique_ptr<duckdb::OperatorState> GetOperatorState(duckdb::ExecutionContext& context) const override;
+    bool ParallelOperator() const override { return true; }
+
+    // Sink interface
+    duckdb::unique_ptr<duckdb::GlobalSinkState> GetGlobalSinkState(duckdb::ClientContext& context) const override;
+    duckdb::unique_ptr<duckdb::LocalSinkState> GetLocalSinkState(duckdb::ExecutionContext& context) const override;
+    duckdb::SinkResultType Sink(duckdb::ExecutionContext& context, duckdb::DataChunk& chunk,
+                                duckdb::OperatorSinkInput& input) const override;
+    duckdb::SinkCombineResultType Combine(duckdb::ExecutionContext& context,
+                                          duckdb::OperatorSinkCombineInput& input) const override;
+    duckdb::SinkFinalizeType Finalize(duckdb::Pipeline& pipeline, duckdb::Event& event,
+                                      duckdb::ClientContext& context,
+                                      duckdb::OperatorSinkFinalizeInput& input) const override;
+    bool IsSink() const override { return true; }
+    bool ParallelSink() const override { return true; }
+
+    std::string GetName() const override { return "LLM_JOIN"; }
+
+protected:
+    duckdb::OperatorResultType ExecuteInternal(duckdb::ExecutionContext& context, duckdb::DataChunk& input,
+                                               duckdb::DataChunk& chunk, duckdb::GlobalOperatorState& gstate,
+                                               duckdb::OperatorState& state) const override;
+};
+
+} // namespace flockmtl
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "flockmtl/core/common.hpp"
+#include "duckdb/execution/physical_operator.hpp"
+#include "duckdb/planner/operator/logical_extension_operator.hpp"
+
+namespace flockmtl {
+
+// Projection whose LLM expressions are evaluated off the DuckDB worker threads.
+class LogicalLlmProjection : public duckdb::LogicalExtensionOperator {
+public:
+    LogicalLlmProjection(idx_t table_index, duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> select_list);
+
+    idx_t table_index;
+
+public:
+    duckdb::unique_ptr<duckdb::PhysicalOperator> CreatePlan(duckdb::ClientContext& context,
+                                                            duckdb::PhysicalPlanGenerator& generator) override;
+    duckdb::vector<duckdb::ColumnBinding> GetColumnBindings() override;
+    duckdb::vector<idx_t> GetTableIndex() const override { return {table_index}; }
+    std::string GetExtensionName() const override { return "flockmtl"; }
+    std::string GetName() const override { return "LLM_PROJECTION"; }
+
+protected:
+    void ResolveTypes() override;
+};
+
+// Sink + source: the sink evaluates the cheap expressions and hands every chunk to the I/O reactor, the source
+// emits finished chunks in input order and blocks (instead of occupying a thread) while responses are outstanding.
+class PhysicalLlmProjection : public duckdb::PhysicalOperator {
+public:
+    PhysicalLlmProjection(duckdb::vector<duckdb::LogicalType> types,
+                          duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> select_list,
+                          idx_t estimated_cardinality, bool use_batch_index);
+
+    duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> select_list;
+    //! Whether each select_list entry has to go through the reactor
+    duckdb::vector<bool> is_llm_expression;
+    //! Whether each select_list entry is an LLM call whose tuples are packed across chunks and threads
+    duckdb::vector<bool> is_coalesced;
+    //! For coalesced entries, the first entry calling the same model on the same tuples, whose request they share
+    duckdb::vector<idx_t> fused_with;
+    bool use_batch_index;
+
+    static bool CanCoalesce(const duckdb::Expression& expression);
+    static bool CanFuse(const duckdb::Expression& lhs, const duckdb::Expression& rhs);
+
+public:
+    // Sink interface
+    duckdb::unique_ptr<duckdb::GlobalSinkState> GetGlobalSinkState(duckdb::ClientContext& context) const override;
+    duckdb::unique_ptr<duckdb::LocalSinkState> GetLocalSinkState(duckdb::ExecutionContext& context) const override;
+    duckdb::SinkResultType Sink(duckdb::ExecutionContext& context, duckdb::DataChunk& chunk,
+                                duckdb::OperatorSinkInput& input) const override;
+    duckdb::SinkFinalizeType Finalize(duckdb::Pipeline& pipeline, duckdb::Event& event,
+                                      duckdb::ClientContext& context,
+                                      duckdb::OperatorSinkFinalizeInput& input) const override;
+    bool IsSink() const override { return true; }
+    bool ParallelSink() const override { return true; }
+    bool RequiresBatchIndex() const override { return use_batch_index; }
+
+    // Source interface
+    duckdb::unique_ptr<duckdb::GlobalSourceState> GetGlobalSourceState(duckdb::ClientContext& context) const override;
+    duckdb::SourceResultType GetData(duckdb::ExecutionContext& context, duckdb::DataChunk& chunk,
+                                     duckdb::OperatorSourceInput& input) const override;
+    bool IsSource() const override { return true; }
+    bool IsOrderPreserving() const override { return use_batch_index; }
+
+    std::string GetName() const override { return "LLM_PROJECTION"; }
+};
+
+} // namespace flockmtl
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "flockmtl/core/common.hpp"
+#include "duckdb/optimizer/optimizer_extension.hpp"
+#include "duckdb/planner/logical_operator.hpp"
+
+namespace flockmtl {
+
+class LlmOptimizer {
+public:
+    static void Optimize(duckdb::OptimizerExtensionInput& input, duckdb::unique_ptr<duckdb::LogicalOperator>& plan);
+
+    static bool IsLlmFunction(const duckdb::Expression& expression);
+    static bool ContainsLlmFunction(const duckdb::Expression& expression);
+
+private:
+    // Splits filters so their LLM conjuncts only see the rows the other conjuncts keep
+    static void OrderLlmPredicates(duckdb::ClientContext& context, duckdb::unique_ptr<duckdb::LogicalOperator>& op);
+    // Merges llm_filter conjuncts calling the same model on the same tuples into one call
+    static void FuseLlmPredicates(duckdb::ClientContext& context,
+                                  duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& predicates);
+    // Moves LLM expressions of projections above the filters and inner joins consuming them, so they are only
+    // computed for the rows that survive
+    static void DeferLlmProjections(duckdb::unique_ptr<duckdb::LogicalOperator>& op,
+                                    duckdb::unique_ptr<duckdb::LogicalOperator>& plan, duckdb::Binder& binder);
+    static bool CanDeferPast(const duckdb::LogicalOperator& op, idx_t child_index);
+    static void RewriteProjections(duckdb::unique_ptr<duckdb::LogicalOperator>& op, bool under_limit);
+    // Turns filters on an llm_filter below a constant LIMIT into LogicalLlmFilter. Stopping at the limit keeps the rows
+    // that happened to pass first, so it is only done when insertion order need not be preserved or nothing is needed.
+    static void RewriteLimitFilters(duckdb::ClientContext& context, duckdb::unique_ptr<duckdb::LogicalOperator>& op);
+    // Turns inner joins on an llm_filter over fields of both sides into LogicalLlmJoin when
+    // flockmtl_join_embedding_model is set
+    static void RewriteLlmJoins(duckdb::ClientContext& context, duckdb::unique_ptr<duckdb::LogicalOperator>& op);
+    // Whether a filter conjunct can be evaluated by LogicalLlmFilter: a direct llm_filter call on constant
+    // model, prompt and threshold arguments
+    static bool IsIncrementalLlmFilter(const duckdb::Expression& expression);
+};
+
+class LlmOptimizerExtension : public duckdb::OptimizerExtension {
+public:
+    LlmOptimizerExtension() { optimize_function = LlmOptimizer::Optimize; }
+};
+
+} // namespace flockmtl
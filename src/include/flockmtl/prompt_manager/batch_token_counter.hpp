@@ -0,0 +1,54 @@
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "flockmtl/prompt_manager/tuple_serializer.hpp"
+
+namespace flockmtl {
+
+// Running token count of a batch as TupleSerializer::Serialize renders it, so batches are packed against what
+// hoisted constant columns and aliased values actually cost rather than against the raw rows.
+class BatchTokenCounter {
+public:
+    explicit BatchTokenCounter(TupleFormat format) : format_(format) {}
+
+    // What adding a tuple costs, measured once and committed by Add so the tuple is not tokenized again
+    struct Measurement {
+        //! Tokens the batch would take once the tuple is added
+        unsigned tokens = 0;
+        //! Tokens of each cell of the tuple, in order, -1 where they were not needed
+        std::vector<int> cell_tokens;
+    };
+
+    Measurement Measure(const nlohmann::json& tuple) const;
+    // `measurement` must come from Measure on the same tuple, with no Add or Clear in between
+    void Add(const nlohmann::json& tuple, const Measurement& measurement);
+    unsigned Tokens() const { return tokens_; }
+    void Clear();
+
+private:
+    struct ColumnState {
+        nlohmann::json value;
+        bool constant;
+        //! Tokens of the cells left out of the rows while the column is hoisted
+        unsigned hoisted_tokens;
+    };
+
+    static constexpr int alias_tokens = 2;
+    static constexpr int alias_definition_tokens = 4;
+
+    int Delta(const nlohmann::json& tuple, std::vector<int>& cell_tokens) const;
+    static int CellTokens(const nlohmann::json& value);
+    static bool IsAliasable(const nlohmann::json& value);
+
+    TupleFormat format_;
+    size_t rows_ = 0;
+    unsigned tokens_ = 0;
+    std::map<std::string, ColumnState> columns_;
+    std::unordered_map<std::string, int> occurrences_;
+};
+
+} // namespace flockmtl
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "flockmtl/prompt_manager/repository.hpp"
+
+namespace flockmtl {
+
+// A prompt template split once into literal and section segments. Rendering appends every segment in a single
+// pass, and the token count of the literal segments is computed once at compile time.
+class CompiledTemplate {
+public:
+    explicit CompiledTemplate(const std::string& prompt_template);
+
+    void RenderInto(std::string& buffer, const std::string& user_prompt, const std::string& tuples) const;
+    std::string Render(const std::string& user_prompt, const std::string& tuples) const;
+
+    // Tokens of the template without its sections
+    int StaticTokens() const { return static_tokens_; }
+
+private:
+    struct Segment {
+        std::string text;
+        bool is_section;
+        PromptSection section;
+    };
+
+    std::vector<Segment> segments_;
+    size_t static_size_ = 0;
+    int static_tokens_ = 0;
+};
+
+} // namespace flockmtl
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <nlohmann/json.hpp>
 #include <fmt/format.h>
 
 #include "flockmtl/core/config.hpp"
 #include "flockmtl/prompt_manager/repository.hpp"
+#include "flockmtl/prompt_manager/tuple_serializer.hpp"
+#include "flockmtl/prompt_manager/batch_token_counter.hpp"
+#include "flockmtl/prompt_manager/compiled_template.hpp"
 
 namespace flockmtl {
 
@@ -31,8 +37,33 @@ public:
         return prompt_template;
     };
 
+    // Compiled once per function type, then shared by every render.
+    template <typename FunctionType>
+    static const CompiledTemplate& GetCompiledTemplate(FunctionType option) {
+        static std::mutex mutex;
+        static std::unordered_map<int, std::unique_ptr<CompiledTemplate>> compiled_templates;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& compiled_template = compiled_templates[static_cast<int>(option)];
+        if (!compiled_template) {
+            compiled_template = std::make_unique<CompiledTemplate>(GetTemplate(option));
+        }
+        return *compiled_template;
+    }
+
+    static const CompiledTemplate& GetTuplesTemplate();
+
+    // Tokens of a rendered prompt that do not depend on the user prompt or the tuples
+    template <typename FunctionType>
+    static int GetStaticTokens(FunctionType option) {
+        return GetCompiledTemplate(option).StaticTokens() + GetTuplesTemplate().StaticTokens();
+    }
+
     static PromptDetails CreatePromptDetails(const nlohmann::json& prompt_details_json);
 
+    // Combines the prompts of several calls into one, the answer to the i-th is keyed FusedTaskKey(i)
+    static std::string FusePrompts(const std::vector<std::pair<std::string, ScalarFunctionType>>& tasks);
+    static std::string FusedTaskKey(size_t index);
+
     static std::string ConstructMarkdownHeader(const nlohmann::json& tuple);
 
     static std::string ConstructMarkdownSingleTuple(const nlohmann::json& tuple);
@@ -40,13 +71,22 @@ public:
     static std::string ConstructMarkdownArrayTuples(const nlohmann::json& tuples);
 
     template <typename FunctionType>
-    static std::string Render(const std::string& user_prompt, const nlohmann::json& tuples, FunctionType option) {
-        auto prompt = PromptManager::GetTemplate(option);
-        auto markdown_tuples = PromptManager::ConstructMarkdownArrayTuples(tuples);
-        prompt = PromptManager::ReplaceSection(prompt, PromptSection::USER_PROMPT, user_prompt);
-        prompt = PromptManager::ReplaceSection(prompt, PromptSection::TUPLES, markdown_tuples);
-        return prompt;
+    static PromptMessages Render(const std::string& user_prompt, const nlohmann::json& tuples, FunctionType option,
+                                 TupleFormat tuple_format = TupleFormat::MARKDOWN) {
+        PromptMessages messages;
+        RenderInto(messages, user_prompt, tuples, option, tuple_format);
+        return messages;
+    };
+
+    template <typename FunctionType>
+    static void RenderInto(PromptMessages& messages, const std::string& user_prompt, const nlohmann::json& tuples,
+                           FunctionType option, TupleFormat tuple_format = TupleFormat::MARKDOWN) {
+        GetCompiledTemplate(option).RenderInto(messages.system, user_prompt, "");
+        GetTuplesTemplate().RenderInto(messages.user, user_prompt, TupleSerializer::Serialize(tuples, tuple_format));
     };
 };
 
+template <>
+std::string PromptManager::ToString<PromptSection>(PromptSection section);
+
 } // namespace flockmtl
@@ -8,12 +8,31 @@ enum class PromptSection { USER_PROMPT, TUPLES, RESPONSE_FORMAT, INSTRUCTIONS };
 
 enum class AggregateFunctionType { REDUCE, REDUCE_JSON, FIRST, LAST, RERANK };
 
-enum class ScalarFunctionType { COMPLETE_JSON, COMPLETE, FILTER };
+enum class ScalarFunctionType {
+    COMPLETE_JSON,
+    COMPLETE,
+    COMPLETE_SCORED,
+    FILTER,
+    FILTER_IDS,
+    FILTER_SCORE,
+    FILTER_PROBABILITY
+};
+
+enum class TupleFormat { MARKDOWN, COMPACT_MARKDOWN, CSV, TSV, JSONL, COLUMNAR };
 
+// The static part of every prompt, sent as a system message ahead of the tuples so that all the batches of a query
+// share the same prefix and benefit from the provider's prompt caching.
 constexpr auto META_PROMPT =
     "You are a semantic analysis tool for DBMS. The tool will analyze each tuple in the provided data and respond to "
-    "user requests based on this context.\n\nUser Prompt:\n\n- {{USER_PROMPT}}\n\nTuples "
-    "Table:\n\n{{TUPLES}}\n\nInstructions:\n\n{{INSTRUCTIONS}}\n\nExpected Response Format:\n\n{{RESPONSE_FORMAT}}";
+    "user requests based on this context.\n\nUser Prompt:\n\n- {{USER_PROMPT}}\n\nInstructions:\n\n{{INSTRUCTIONS}}"
+    "\n\nExpected Response Format:\n\n{{RESPONSE_FORMAT}}";
+
+constexpr auto TUPLES_PROMPT = "Tuples Table:\n\n{{TUPLES}}";
+
+struct PromptMessages {
+    std::string system;
+    std::string user;
+};
 
 class INSTRUCTIONS {
 public:
@@ -38,16 +57,36 @@ public:
     static constexpr auto COMPLETE_JSON =
         "The system should interpret database tuples and provide a response to the user's prompt for each tuple in a "
         "JSON format that contains the necessary columns for the answer.\n\nThe tool should respond in JSON format as "
-        "follows:\n\n```json\n{\t\"tuples\": [\n\t\t{<response 1>},\n\t\t{<response 2>},\n\t\t...\n\t\t{<response "
-        "n>}\n\t]\n}\n```";
+        "follows, with one entry per tuple carrying its flockmtl_tuple_id:\n\n```json\n{\t\"tuples\": [\n\t\t{\"id\": "
+        "<flockmtl_tuple_id 1>, \"response\": {<response 1>}},\n\t\t...\n\t\t{\"id\": <flockmtl_tuple_id n>, "
+        "\"response\": {<response n>}}\n\t]\n}\n```";
     static constexpr auto COMPLETE =
         "The system should interpret database tuples and provide a response to the user's prompt for each tuple in "
-        "plain text.\n\tThe tool should respond in JSON format as follows:\n\n```json\n{\"tuples\": [\"<response 1>\", "
-        "\"<response 2>\", ... , \"<response n>\"]}";
+        "plain text.\n\tThe tool should respond in JSON format as follows, with one entry per tuple carrying its "
+        "flockmtl_tuple_id:\n\n```json\n{\"tuples\": [{\"id\": <flockmtl_tuple_id 1>, \"response\": \"<response 1>\"}, "
+        "... , {\"id\": <flockmtl_tuple_id n>, \"response\": \"<response n>\"}]}";
+    static constexpr auto COMPLETE_SCORED =
+        "The system should interpret database tuples and provide a response to the user's prompt for each tuple in "
+        "plain text, together with its confidence between 0 and 1 that the response is correct.\n\tThe tool should "
+        "respond in JSON format as follows, with one entry per tuple carrying its flockmtl_tuple_id:\n\n```json\n"
+        "{\"tuples\": [{\"id\": <flockmtl_tuple_id 1>, \"response\": {\"answer\": \"<response 1>\", \"confidence\": "
+        "<confidence 1>}}, ... , {\"id\": <flockmtl_tuple_id n>, \"response\": {\"answer\": \"<response n>\", "
+        "\"confidence\": <confidence n>}}]}";
     static constexpr auto FILTER =
         "The system should interpret database tuples and provide a response to the user's prompt for each tuple in a "
-        "BOOL format that would be true/false.\n\tThe tool should respond in JSON format as "
-        "follows:\n\n```json\n{\"tuples\": [<bool response 1>, <bool response 2>, ... , <bool response n>]}";
+        "BOOL format that would be true/false.\n\tThe tool should respond in JSON format as follows, with one entry "
+        "per tuple carrying its flockmtl_tuple_id:\n\n```json\n{\"tuples\": [{\"id\": <flockmtl_tuple_id 1>, "
+        "\"response\": <bool response 1>}, ... , {\"id\": <flockmtl_tuple_id n>, \"response\": <bool response n>}]}";
+    static constexpr auto FILTER_IDS =
+        "The system should interpret database tuples and decide for each tuple whether it satisfies the user's "
+        "prompt.\n\tThe tool should respond in JSON format with only the flockmtl_tuple_id of the tuples that "
+        "satisfy it, as follows:\n\n```json\n{\"tuples\": [<flockmtl_tuple_id>, <flockmtl_tuple_id>, ...]}\n```"
+        "\n\nRespond with an empty list when no tuple satisfies the prompt.";
+    static constexpr auto FILTER_SCORE =
+        "The system should interpret database tuples and provide, for each tuple, the confidence between 0 and 1 that "
+        "it satisfies the user's prompt.\n\tThe tool should respond in JSON format as follows, with one entry per "
+        "tuple carrying its flockmtl_tuple_id:\n\n```json\n{\"tuples\": [{\"id\": <flockmtl_tuple_id 1>, \"response\": "
+        "<confidence 1>}, ... , {\"id\": <flockmtl_tuple_id n>, \"response\": <confidence n>}]}";
 
     // Aggregate Functions
     static constexpr auto REDUCE =
@@ -73,6 +112,20 @@ public:
     static std::string Get(const FunctionType option);
 };
 
+// User prompt of several scalar calls over the same tuples answered by one COMPLETE_JSON request.
+class FUSED_PROMPT {
+public:
+    static constexpr auto HEADER =
+        "Complete every one of the following tasks for each tuple. The response of a tuple must be a JSON object "
+        "with one key per task, holding the answer to that task:";
+    static constexpr auto COMPLETE = "plain text";
+    static constexpr auto COMPLETE_JSON = "a JSON object that contains the necessary columns for the answer";
+    static constexpr auto FILTER = "true or false, whether the tuple satisfies the task";
+    static constexpr auto FILTER_SCORE = "the confidence between 0 and 1 that the tuple satisfies the task";
+    //! Several llm_filter conjuncts answered as one condition
+    static constexpr auto CONJUNCTION = "Decide whether the tuple satisfies all of the following conditions:";
+};
+
 struct PromptDetails {
     std::string prompt_name;
     std::string prompt;
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <nlohmann/json.hpp>
+
+#include "flockmtl/prompt_manager/repository.hpp"
+
+namespace flockmtl {
+
+// Renders tuples into the {{TUPLES}} section of a prompt. Strings are written raw wherever the format allows it,
+// numbers and booleans are never quoted.
+class TupleSerializer {
+public:
+    static TupleFormat ParseFormat(const std::string& format);
+    static std::string FormatName(TupleFormat format);
+
+    // Part of a batch written once whatever its size (e.g. the column names)
+    static std::string SerializeHeader(const nlohmann::json& tuple, TupleFormat format);
+    // Part of a batch added by one tuple, used to budget batches
+    static std::string SerializeTuple(const nlohmann::json& tuple, TupleFormat format);
+    static std::string Serialize(const nlohmann::json& tuples, TupleFormat format);
+
+    static std::string ValueToText(const nlohmann::json& value);
+
+    //! Repeated strings at least this long are replaced by an alias defined once per batch
+    static constexpr size_t min_alias_length = 24;
+
+private:
+    static std::string Escape(const std::string& text, TupleFormat format);
+    // Moves columns that are constant across the batch, and the definitions of repeated long strings, into a
+    // preamble. Returns an empty preamble (and leaves compacted untouched) when nothing can be saved.
+    static std::string CompactBatch(const nlohmann::json& tuples, nlohmann::json& compacted);
+};
+
+} // namespace flockmtl
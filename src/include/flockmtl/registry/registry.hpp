@@ -3,6 +3,7 @@
 #include "flockmtl/core/common.hpp"
 #include "flockmtl/registry/aggregate.hpp"
 #include "flockmtl/registry/scalar.hpp"
+#include "flockmtl/registry/table.hpp"
 
 namespace flockmtl {
 
@@ -13,6 +14,7 @@ public:
 private:
     static void RegisterAggregateFunctions(duckdb::DatabaseInstance& db);
     static void RegisterScalarFunctions(duckdb::DatabaseInstance& db);
+    static void RegisterTableFunctions(duckdb::DatabaseInstance& db);
 };
 
 } // namespace flockmtl
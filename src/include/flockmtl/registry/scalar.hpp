@@ -13,6 +13,7 @@ private:
     static void RegisterLlmComplete(duckdb::DatabaseInstance& db);
     static void RegisterLlmEmbedding(duckdb::DatabaseInstance& db);
     static void RegisterLlmFilter(duckdb::DatabaseInstance& db);
+    static void RegisterLlmFilterScore(duckdb::DatabaseInstance& db);
     static void RegisterFusionRelative(duckdb::DatabaseInstance& db);
 };
 
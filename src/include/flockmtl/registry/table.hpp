@@ -0,0 +1,17 @@
+#pragma once
+
+#include "flockmtl/core/common.hpp"
+
+namespace flockmtl {
+
+class TableRegistry {
+public:
+    static void Register(duckdb::DatabaseInstance& db);
+
+private:
+    static void RegisterFlockmtlCascadeStats(duckdb::DatabaseInstance& db);
+    static void RegisterFlockmtlPrefilterStats(duckdb::DatabaseInstance& db);
+    static void RegisterFlockmtlUsage(duckdb::DatabaseInstance& db);
+};
+
+} // namespace flockmtl
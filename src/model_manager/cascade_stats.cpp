@@ -0,0 +1,26 @@
+#include "flockmtl/model_manager/cascade_stats.hpp"
+
+namespace flockmtl {
+
+std::mutex CascadeStats::mutex_;
+std::map<std::pair<int32_t, std::string>, CascadeStats::Entry> CascadeStats::stages_;
+
+void CascadeStats::Record(const int32_t stage, const std::string& model, const int64_t rows, const int64_t escalated) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = stages_[{stage, model}];
+    entry.stage = stage;
+    entry.model = model;
+    entry.rows += rows;
+    entry.escalated += escalated;
+}
+
+std::vector<CascadeStats::Entry> CascadeStats::Snapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Entry> entries;
+    for (const auto& [key, entry] : stages_) {
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+} // namespace flockmtl
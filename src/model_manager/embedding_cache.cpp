@@ -0,0 +1,131 @@
+#include "flockmtl/model_manager/embedding_cache.hpp"
+#include "flockmtl/prompt_manager/tuple_serializer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace flockmtl {
+
+EmbeddingCache& EmbeddingCache::Get() {
+    static EmbeddingCache cache;
+    return cache;
+}
+
+std::vector<std::vector<float>> EmbeddingCache::Embed(Model& model, const std::vector<std::string>& texts) {
+    const auto model_details = model.GetModelDetails();
+    const auto prefix = model_details.provider_name + "\n" + model_details.model + "\n";
+
+    std::vector<std::vector<float>> embeddings(texts.size());
+    std::vector<std::string> missing;
+    std::unordered_map<std::string, std::vector<size_t>> missing_positions;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < texts.size(); i++) {
+            auto entry = embeddings_.find(prefix + texts[i]);
+            if (entry != embeddings_.end()) {
+                embeddings[i] = entry->second;
+                continue;
+            }
+            auto& positions = missing_positions[texts[i]];
+            if (positions.empty()) {
+                missing.push_back(texts[i]);
+            }
+            positions.push_back(i);
+        }
+    }
+    if (missing.empty()) {
+        return embeddings;
+    }
+
+    // Providers cap the inputs of one request
+    const auto batch_size = static_cast<size_t>(Config::default_embedding_batch_size);
+    for (size_t start = 0; start < missing.size(); start += batch_size) {
+        const auto end = std::min(missing.size(), start + batch_size);
+        auto response = model.CallEmbedding(std::vector<std::string>(missing.begin() + start, missing.begin() + end));
+        if (response.size() != end - start) {
+            throw std::runtime_error(
+                fmt::format("Expected {} embeddings from the model but got {}", end - start, response.size()));
+        }
+        for (size_t i = start; i < end; i++) {
+            auto embedding = response[i - start].get<std::vector<float>>();
+            for (const auto position : missing_positions[missing[i]]) {
+                embeddings[position] = embedding;
+            }
+            Store(prefix + missing[i], std::move(embedding));
+        }
+    }
+    return embeddings;
+}
+
+std::vector<double> EmbeddingCache::Similarities(Model& model, const std::string& text,
+                                                 const std::vector<nlohmann::json>& tuples) {
+    std::vector<std::string> texts;
+    texts.reserve(tuples.size() + 1);
+    texts.push_back(text);
+    for (const auto& tuple : tuples) {
+        texts.push_back(TupleText(tuple));
+    }
+    auto embeddings = Embed(model, texts);
+
+    std::vector<double> similarities;
+    similarities.reserve(tuples.size());
+    for (size_t i = 0; i < tuples.size(); i++) {
+        similarities.push_back(CosineSimilarity(embeddings[0], embeddings[i + 1]));
+    }
+    return similarities;
+}
+
+std::string EmbeddingCache::TupleText(const nlohmann::json& tuple) {
+    std::string text;
+    for (const auto& item : tuple.items()) {
+        text += TupleSerializer::ValueToText(item.value()) + " ";
+    }
+    return text;
+}
+
+double EmbeddingCache::CosineSimilarity(const std::vector<float>& lhs, const std::vector<float>& rhs) {
+    // Accumulated in double precision, the stored values are floats
+    double dot = 0, lhs_norm = 0, rhs_norm = 0;
+    for (size_t i = 0; i < lhs.size() && i < rhs.size(); i++) {
+        dot += static_cast<double>(lhs[i]) * rhs[i];
+        lhs_norm += static_cast<double>(lhs[i]) * lhs[i];
+        rhs_norm += static_cast<double>(rhs[i]) * rhs[i];
+    }
+    if (lhs_norm == 0 || rhs_norm == 0) {
+        return 0;
+    }
+    return dot / (std::sqrt(lhs_norm) * std::sqrt(rhs_norm));
+}
+
+void EmbeddingCache::SetCapacity(const idx_t capacity_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_bytes_ = capacity_bytes;
+    Evict();
+}
+
+idx_t EmbeddingCache::EntryBytes(const std::string& key, const std::vector<float>& embedding) {
+    // The key is stored twice, in the map and in the insertion order
+    return 2 * key.size() + embedding.size() * sizeof(float);
+}
+
+void EmbeddingCache::Store(const std::string& key, std::vector<float> embedding) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto bytes = EntryBytes(key, embedding);
+    if (!embeddings_.emplace(key, std::move(embedding)).second) {
+        return;
+    }
+    insertion_order_.push_back(key);
+    bytes_ += bytes;
+    Evict();
+}
+
+void EmbeddingCache::Evict() {
+    while (bytes_ > capacity_bytes_ && !insertion_order_.empty()) {
+        auto entry = embeddings_.find(insertion_order_.front());
+        bytes_ -= EntryBytes(entry->first, entry->second);
+        embeddings_.erase(entry);
+        insertion_order_.pop_front();
+    }
+}
+
+} // namespace flockmtl
@@ -1,9 +1,11 @@
 #include "flockmtl/model_manager/model.hpp"
+#include "flockmtl/model_manager/single_flight.hpp"
 #include "flockmtl/secret_manager/secret_manager.hpp"
+#include "flockmtl/prompt_manager/tuple_serializer.hpp"
 
 namespace flockmtl {
 
-Model::Model(const nlohmann::json& model_json) {
+Model::Model(const nlohmann::json& model_json) : model_json_(model_json) {
     LoadModelDetails(model_json);
     ConstructProvider();
 }
@@ -25,15 +27,112 @@ void Model::LoadModelDetails(const nlohmann::json& model_json) {
         secret_name = model_json["secret_name"].get<std::string>();
     }
     model_details_.secret = SecretManager::GetSecret(secret_name);
-    model_details_.context_window =
-        model_json.contains("context_window") ? model_json.at("context_window").get<int>() : std::get<2>(query_result);
+    auto& model_args = std::get<2>(query_result);
+    model_details_.context_window = model_json.contains("context_window")
+                                        ? model_json.at("context_window").get<int>()
+                                        : model_args.at("context_window").get<int>();
     model_details_.max_output_tokens = model_json.contains("max_output_tokens")
                                            ? model_json.at("max_output_tokens").get<int>()
-                                           : std::get<3>(query_result);
+                                           : model_args.at("max_output_tokens").get<int>();
+    auto timeout = [&](const std::string& key, const int default_seconds) {
+        if (model_json.contains(key)) {
+            return ParseSeconds(key, model_json.at(key));
+        }
+        return model_args.contains(key) ? ParseSeconds(key, model_args.at(key)) : default_seconds;
+    };
+    model_details_.connect_timeout = timeout("connect_timeout", Config::default_connect_timeout);
+    model_details_.request_timeout = timeout("request_timeout", Config::default_request_timeout);
     model_details_.temperature = model_json.contains("temperature") ? model_json.at("temperature").get<float>() : 0.5;
+    model_details_.tuple_format = TupleSerializer::ParseFormat(
+        model_json.contains("tuple_format") ? model_json.at("tuple_format").get<std::string>()
+                                            : model_args.value("tuple_format", std::string("markdown")));
+    auto cascade = model_args.value("cascade", nlohmann::json());
+    if (model_json.contains("cascade")) {
+        cascade = model_json.at("cascade");
+    }
+    model_details_.cascade = ParseCascade(cascade);
+    model_details_.cascade_threshold =
+        model_json.contains("cascade_threshold")
+            ? model_json.at("cascade_threshold").get<double>()
+            : model_args.value("cascade_threshold", Config::default_cascade_threshold);
+}
+
+int Model::ParseSeconds(const std::string& key, const nlohmann::json& value) {
+    // Values of the model struct arrive as text unless the struct was built from typed columns
+    if (value.is_number_integer()) {
+        return value.get<int>();
+    }
+    if (value.is_string()) {
+        try {
+            size_t parsed = 0;
+            const auto seconds = std::stoi(value.get<std::string>(), &parsed);
+            if (parsed == value.get<std::string>().size()) {
+                return seconds;
+            }
+        } catch (const std::exception&) {
+        }
+    }
+    throw std::invalid_argument(duckdb_fmt::format("`{}` must be a whole number of seconds", key));
+}
+
+std::vector<std::string> Model::ParseCascade(const nlohmann::json& cascade) {
+    std::vector<std::string> model_names;
+    if (cascade.is_array()) {
+        for (const auto& model_name : cascade) {
+            model_names.push_back(model_name.get<std::string>());
+        }
+        return model_names;
+    }
+    if (!cascade.is_string()) {
+        return model_names;
+    }
+    // Lists in the model struct arrive as their text form, e.g. `[gpt-4o-mini, gpt-4o]`
+    auto text = cascade.get<std::string>();
+    if (!text.empty() && text.front() == '[' && text.back() == ']') {
+        text = text.substr(1, text.size() - 2);
+    }
+    for (auto& model_name : duckdb::StringUtil::Split(text, ',')) {
+        duckdb::StringUtil::Trim(model_name);
+        if (model_name.size() >= 2 && model_name.front() == '\'' && model_name.back() == '\'') {
+            model_name = model_name.substr(1, model_name.size() - 2);
+        }
+        if (!model_name.empty()) {
+            model_names.push_back(model_name);
+        }
+    }
+    return model_names;
+}
+
+std::vector<std::string> Model::GetCascade(const nlohmann::json& model_json) {
+    if (model_json.contains("cascade")) {
+        return ParseCascade(model_json.at("cascade"));
+    }
+    if (!model_json.contains("model_name")) {
+        return {};
+    }
+    const auto model_args = std::get<2>(GetQueriedModel(model_json.at("model_name").get<std::string>()));
+    return ParseCascade(model_args.value("cascade", nlohmann::json()));
 }
 
-std::tuple<std::string, std::string, int32_t, int32_t> Model::GetQueriedModel(const std::string& model_name) {
+Model Model::Escalate(const std::string& model_name) const {
+    // Per-call settings such as the secret carry over, the model and provider resolve for the new name
+    auto model_json = model_json_;
+    model_json["model_name"] = model_name;
+    model_json.erase("model");
+    model_json.erase("provider");
+    Model model(model_json);
+    model.SetAbortCheck(abort_check_);
+    model.model_details_.cascade.clear();
+    return model;
+}
+
+Model Model::WithoutCascade() const {
+    auto model = *this;
+    model.model_details_.cascade.clear();
+    return model;
+}
+
+std::tuple<std::string, std::string, nlohmann::json> Model::GetQueriedModel(const std::string& model_name) {
     const std::string query =
         duckdb_fmt::format(" SELECT model, provider_name, model_args "
                            " FROM flockmtl_storage.flockmtl_config.FLOCKMTL_MODEL_USER_DEFINED_INTERNAL_TABLE"
@@ -63,7 +162,7 @@ std::tuple<std::string, std::string, int32_t, int32_t> Model::GetQueriedModel(co
     auto provider_name = query_result->GetValue(1, 0).ToString();
     auto model_args = nlohmann::json::parse(query_result->GetValue(2, 0).ToString());
 
-    return {model, provider_name, model_args["context_window"], model_args["max_output_tokens"]};
+    return {model, provider_name, model_args};
 }
 
 void Model::ConstructProvider() {
@@ -82,12 +181,68 @@ void Model::ConstructProvider() {
     }
 }
 
+void Model::SetAbortCheck(std::function<bool()> abort_check) {
+    abort_check_ = std::move(abort_check);
+    if (provider_) {
+        provider_->abort_check_ = abort_check_;
+    }
+}
+
+void Model::SetInterruptFlag(const std::atomic<bool>& interrupted) {
+    SetAbortCheck([&interrupted]() { return interrupted.load(); });
+}
+
+void Model::ThrowIfAborted() {
+    if (abort_check_ && abort_check_()) {
+        throw duckdb::InterruptException();
+    }
+}
+
 ModelDetails Model::GetModelDetails() { return model_details_; }
 
 nlohmann::json Model::CallComplete(const std::string& prompt, bool json_response) {
-    return provider_->CallComplete(prompt, json_response);
+    return CallComplete(PromptMessages{"", prompt}, json_response);
+}
+
+std::string Model::RequestKey(const PromptMessages& prompt, const bool json_response,
+                              const CompletionOptions& options) const {
+    // The credentials are part of the key, requests are only shared between callers of the same account
+    std::string secret;
+    for (const auto& [key, value] : model_details_.secret) {
+        secret += key + "=" + value + "\n";
+    }
+    return fmt::format("{}\n{}\n{}\n{}\n{}\n{}\n{}\n{}\n{}\n{}", model_details_.provider_name, model_details_.model,
+                       model_details_.temperature, model_details_.max_output_tokens, std::hash<std::string>()(secret),
+                       json_response, options.logprobs, options.response_schema.dump(), prompt.system,
+                       prompt.user);
 }
 
-nlohmann::json Model::CallEmbedding(const std::vector<std::string>& inputs) { return provider_->CallEmbedding(inputs); }
+nlohmann::json Model::CallComplete(const PromptMessages& prompt, bool json_response,
+                                   const CompletionOptions& options) {
+    // Checking before the call drains the remaining batches of a cancelled query without sending them
+    ThrowIfAborted();
+    return SingleFlight::Get().Do(
+        RequestKey(prompt, json_response, options),
+        [&]() {
+            try {
+                return provider_->CallComplete(prompt, json_response, options);
+            } catch (const std::exception&) {
+                // An aborted transfer surfaces as a curl error, report it as the interrupt it is
+                ThrowIfAborted();
+                throw;
+            }
+        },
+        [this]() { ThrowIfAborted(); });
+}
+
+nlohmann::json Model::CallEmbedding(const std::vector<std::string>& inputs) {
+    ThrowIfAborted();
+    try {
+        return provider_->CallEmbedding(inputs);
+    } catch (const std::exception&) {
+        ThrowIfAborted();
+        throw;
+    }
+}
 
 } // namespace flockmtl
@@ -2,29 +2,50 @@
 
 namespace flockmtl {
 
-nlohmann::json AzureProvider::CallComplete(const std::string& prompt, const bool json_response) {
+nlohmann::json AzureProvider::CallComplete(const PromptMessages& prompt, const bool json_response,
+                                           const CompletionOptions& options) {
     auto azure_model_manager_uptr =
         std::make_unique<AzureModelManager>(model_details_.secret["api_key"], model_details_.secret["resource_name"],
                                             model_details_.model, model_details_.secret["api_version"], true);
+    azure_model_manager_uptr->SetTimeouts(model_details_.connect_timeout, model_details_.request_timeout);
+    azure_model_manager_uptr->SetAbortCheck(abort_check_);
+
+    // Same layout as the OpenAI adapter: the cacheable static prefix, then the tuples
+    auto messages = nlohmann::json::array();
+    if (!prompt.system.empty()) {
+        messages.push_back({{"role", "system"}, {"content", prompt.system}});
+    }
+    messages.push_back({{"role", "user"}, {"content", prompt.user}});
 
     // Create a JSON request payload with the provided parameters
     nlohmann::json request_payload = {{"model", model_details_.model},
-                                      {"messages", {{{"role", "user"}, {"content", prompt}}}},
+                                      {"messages", messages},
                                       {"max_tokens", model_details_.max_output_tokens},
                                       {"temperature", model_details_.temperature}};
 
     // Conditionally add "response_format" if json_response is true
-    if (json_response) {
+    if (json_response && !options.response_schema.is_null()) {
+        request_payload["response_format"] = {
+            {"type", "json_schema"},
+            {"json_schema", {{"name", "flockmtl_response"}, {"strict", true}, {"schema", options.response_schema}}}};
+    } else if (json_response) {
         request_payload["response_format"] = {{"type", "json_object"}};
     }
+    if (options.logprobs) {
+        request_payload["logprobs"] = true;
+        request_payload["top_logprobs"] = TOP_LOGPROBS;
+    }
 
     // Make a request to the Azure API
     auto completion = azure_model_manager_uptr->CallComplete(request_payload);
 
+    UsageStats::Record(model_details_, UsageStats::FromChatCompletion(completion));
+
     // Check if the conversation was too long for the context window
     if (completion["choices"][0]["finish_reason"] == "length") {
         // Handle the error when the context window is too long
-        throw ExceededMaxOutputTokensError();
+        const auto& partial_content = completion["choices"][0]["message"]["content"];
+        throw ExceededMaxOutputTokensError(partial_content.is_string() ? partial_content.get<std::string>() : "");
     }
 
     // Check if the safety system refused the request
@@ -44,7 +65,12 @@ nlohmann::json AzureProvider::CallComplete(const std::string& prompt, const bool
     std::string content_str = completion["choices"][0]["message"]["content"];
 
     if (json_response) {
-        return nlohmann::json::parse(content_str);
+        auto response = ResponseParser::Parse(content_str);
+        const auto& choice = completion["choices"][0];
+        if (options.logprobs && choice.contains("logprobs") && choice["logprobs"].is_object()) {
+            AttachProbabilities(response, choice["logprobs"].value("content", nlohmann::json()));
+        }
+        return response;
     }
 
     return content_str;
@@ -54,6 +80,8 @@ nlohmann::json AzureProvider::CallEmbedding(const std::vector<std::string>& inpu
     auto azure_model_manager_uptr =
         std::make_unique<AzureModelManager>(model_details_.secret["api_key"], model_details_.secret["resource_name"],
                                             model_details_.model, model_details_.secret["api_version"], true);
+    azure_model_manager_uptr->SetTimeouts(model_details_.connect_timeout, model_details_.request_timeout);
+    azure_model_manager_uptr->SetAbortCheck(abort_check_);
 
     // Create a JSON request payload with the provided parameters
     nlohmann::json request_payload = {
@@ -2,12 +2,15 @@
 
 namespace flockmtl {
 
-nlohmann::json OllamaProvider::CallComplete(const std::string& prompt, const bool json_response) {
+nlohmann::json OllamaProvider::CallComplete(const PromptMessages& prompt, const bool json_response,
+                                            const CompletionOptions& options) {
     auto ollama_model_manager_uptr = std::make_unique<OllamaModelManager>(model_details_.secret["api_url"], true);
+    ollama_model_manager_uptr->SetTimeouts(model_details_.connect_timeout, model_details_.request_timeout);
+    ollama_model_manager_uptr->SetAbortCheck(abort_check_);
 
     // Create a JSON request payload with the provided parameters
     nlohmann::json request_payload = {{"model", model_details_.model},
-                                      {"prompt", prompt},
+                                      {"prompt", prompt.user},
                                       {"stream", false},
                                       {"options",
                                        {
@@ -16,9 +19,19 @@ nlohmann::json OllamaProvider::CallComplete(const std::string& prompt, const boo
                                        }},
                                       {"keep_alive", -1}};
 
+    // Replaces the model's default system prompt, so only set it when there is one
+    if (!prompt.system.empty()) {
+        request_payload["system"] = prompt.system;
+    }
+
     // Conditionally add "response_format" if json_response is true
     if (json_response) {
-        request_payload["format"] = "json";
+        request_payload["format"] =
+            options.response_schema.is_null() ? nlohmann::json("json") : options.response_schema;
+    }
+    if (options.logprobs) {
+        request_payload["logprobs"] = true;
+        request_payload["top_logprobs"] = TOP_LOGPROBS;
     }
 
     nlohmann::json completion;
@@ -28,6 +41,17 @@ nlohmann::json OllamaProvider::CallComplete(const std::string& prompt, const boo
         throw std::runtime_error(duckdb_fmt::format("Error in making request to Ollama API: {}", e.what()));
     }
 
+    // Ollama reuses the KV cache of a matching prefix but does not report how much of the prompt it covered
+    TokenUsage usage;
+    usage.requests = 1;
+    usage.input_tokens = completion.value("prompt_eval_count", int64_t(0));
+    usage.output_tokens = completion.value("eval_count", int64_t(0));
+    UsageStats::Record(model_details_, usage);
+
+    if (completion.contains("done_reason") && completion["done_reason"] == "length") {
+        throw ExceededMaxOutputTokensError(completion.value("response", std::string()));
+    }
+
     // Check if the call was not succesfull
     if ((completion.contains("done_reason") && completion["done_reason"] != "stop") ||
         (completion.contains("done") && !completion["done"].is_null() && completion["done"].get<bool>() != true)) {
@@ -38,7 +62,11 @@ nlohmann::json OllamaProvider::CallComplete(const std::string& prompt, const boo
     std::string content_str = completion["response"];
 
     if (json_response) {
-        return nlohmann::json::parse(content_str);
+        auto response = ResponseParser::Parse(content_str);
+        if (options.logprobs && completion.contains("logprobs")) {
+            AttachProbabilities(response, completion["logprobs"]);
+        }
+        return response;
     }
 
     return content_str;
@@ -46,6 +74,8 @@ nlohmann::json OllamaProvider::CallComplete(const std::string& prompt, const boo
 
 nlohmann::json OllamaProvider::CallEmbedding(const std::vector<std::string>& inputs) {
     auto ollama_model_manager_uptr = std::make_unique<OllamaModelManager>(model_details_.secret["api_url"], true);
+    ollama_model_manager_uptr->SetTimeouts(model_details_.connect_timeout, model_details_.request_timeout);
+    ollama_model_manager_uptr->SetAbortCheck(abort_check_);
 
     auto embeddings = nlohmann::json::array();
     for (const auto& input : inputs) {
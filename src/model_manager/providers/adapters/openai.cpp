@@ -2,23 +2,41 @@
 
 namespace flockmtl {
 
-nlohmann::json OpenAIProvider::CallComplete(const std::string& prompt, bool json_response) {
+nlohmann::json OpenAIProvider::CallComplete(const PromptMessages& prompt, bool json_response,
+                                            const CompletionOptions& options) {
     auto base_url = std::string("");
     if (const auto it = model_details_.secret.find("base_url"); it != model_details_.secret.end()) {
         base_url = it->second;
     }
     auto openai = openai::OpenAI(model_details_.secret["api_key"], "", true, base_url);
+    openai.setTimeouts(model_details_.connect_timeout, model_details_.request_timeout);
+    openai.setAbortCheck(abort_check_);
+
+    // The static instructions go first so that every batch of a query shares a cacheable prefix
+    auto messages = nlohmann::json::array();
+    if (!prompt.system.empty()) {
+        messages.push_back({{"role", "system"}, {"content", prompt.system}});
+    }
+    messages.push_back({{"role", "user"}, {"content", prompt.user}});
 
     // Create a JSON request payload with the provided parameters
     nlohmann::json request_payload = {{"model", model_details_.model},
-                                      {"messages", {{{"role", "user"}, {"content", prompt}}}},
+                                      {"messages", messages},
                                       {"max_tokens", model_details_.max_output_tokens},
                                       {"temperature", model_details_.temperature}};
 
     // Conditionally add "response_format" if json_response is true
-    if (json_response) {
+    if (json_response && !options.response_schema.is_null()) {
+        request_payload["response_format"] = {
+            {"type", "json_schema"},
+            {"json_schema", {{"name", "flockmtl_response"}, {"strict", true}, {"schema", options.response_schema}}}};
+    } else if (json_response) {
         request_payload["response_format"] = {{"type", "json_object"}};
     }
+    if (options.logprobs) {
+        request_payload["logprobs"] = true;
+        request_payload["top_logprobs"] = TOP_LOGPROBS;
+    }
 
     // Make a request to the OpenAI API
     nlohmann::json completion;
@@ -27,10 +45,13 @@ nlohmann::json OpenAIProvider::CallComplete(const std::string& prompt, bool json
     } catch (const std::exception& e) {
         throw std::runtime_error("Error in making request to OpenAI API: " + std::string(e.what()));
     }
+    UsageStats::Record(model_details_, UsageStats::FromChatCompletion(completion));
+
     // Check if the conversation was too long for the context window
     if (completion["choices"][0]["finish_reason"] == "length") {
         // Handle the error when the context window is too long
-        throw ExceededMaxOutputTokensError();
+        const auto& partial_content = completion["choices"][0]["message"]["content"];
+        throw ExceededMaxOutputTokensError(partial_content.is_string() ? partial_content.get<std::string>() : "");
     }
 
     // Check if the OpenAI safety system refused the request
@@ -50,7 +71,12 @@ nlohmann::json OpenAIProvider::CallComplete(const std::string& prompt, bool json
     std::string content_str = completion["choices"][0]["message"]["content"];
 
     if (json_response) {
-        return nlohmann::json::parse(content_str);
+        auto response = ResponseParser::Parse(content_str);
+        const auto& choice = completion["choices"][0];
+        if (options.logprobs && choice.contains("logprobs") && choice["logprobs"].is_object()) {
+            AttachProbabilities(response, choice["logprobs"].value("content", nlohmann::json()));
+        }
+        return response;
     }
 
     return content_str;
@@ -62,6 +88,8 @@ nlohmann::json OpenAIProvider::CallEmbedding(const std::vector<std::string>& inp
         base_url = it->second;
     }
     auto openai = openai::OpenAI(model_details_.secret["api_key"], "", true, base_url);
+    openai.setTimeouts(model_details_.connect_timeout, model_details_.request_timeout);
+    openai.setAbortCheck(abort_check_);
 
     // Create a JSON request payload with the provided parameters
     nlohmann::json request_payload = {
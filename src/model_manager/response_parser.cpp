@@ -0,0 +1,238 @@
+#include "flockmtl/model_manager/response_parser.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <stdexcept>
+
+namespace flockmtl {
+
+nlohmann::json ResponseParser::Parse(const std::string& content) {
+    // A fence can only be told apart from backticks inside a string value when the raw text is not JSON already
+    auto parsed = nlohmann::json::parse(content, nullptr, false);
+    if (!parsed.is_discarded()) {
+        return parsed;
+    }
+    const auto stripped = StripCodeFence(content);
+    if (stripped.size() != content.size()) {
+        parsed = nlohmann::json::parse(stripped, nullptr, false);
+        if (!parsed.is_discarded()) {
+            return parsed;
+        }
+    }
+    nlohmann::json repaired;
+    if (TryRepairTruncated(stripped, repaired)) {
+        return repaired;
+    }
+    throw std::runtime_error("The model returned malformed JSON: " + content.substr(0, 200));
+}
+
+std::string ResponseParser::StripCodeFence(const std::string& content) {
+    // Only a fence opening the completion is stripped
+    const auto fence = content.find_first_not_of(" \t\r\n");
+    if (fence == std::string::npos || content.compare(fence, 3, "```") != 0) {
+        return content;
+    }
+    // Skip the language tag on the opening line
+    auto start = content.find('\n', fence);
+    start = start == std::string::npos ? fence + 3 : start + 1;
+    // The closing fence ends the completion, backticks inside the JSON come before it. A cut completion has none.
+    auto end = content.rfind("```");
+    if (end == std::string::npos || end < start || content.find_first_not_of(" \t\r\n", end + 3) != std::string::npos) {
+        end = content.size();
+    }
+    return content.substr(start, end - start);
+}
+
+bool ResponseParser::TryRepairTruncated(const std::string& content, nlohmann::json& repaired) {
+    // Closing brackets of the open containers, and the last place where the text can be cut between two array
+    // elements
+    std::string closers;
+    std::string cut_closers;
+    size_t cut = std::string::npos;
+    auto in_string = false;
+    auto escaped = false;
+
+    for (size_t i = 0; i < content.size(); i++) {
+        const auto c = content[i];
+        if (in_string) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                in_string = false;
+            }
+            continue;
+        }
+        switch (c) {
+        case '"':
+            in_string = true;
+            break;
+        case '{':
+            closers.push_back('}');
+            break;
+        case '[':
+            closers.push_back(']');
+            // An empty container is a valid cut as well
+            cut = i + 1;
+            cut_closers = closers;
+            break;
+        case '}':
+        case ']':
+            if (closers.empty() || closers.back() != c) {
+                return false;
+            }
+            closers.pop_back();
+            if (closers.empty() || closers.back() == ']') {
+                cut = i + 1;
+                cut_closers = closers;
+            }
+            break;
+        case ',':
+            // Objects are never cut, a partial object could look like a complete answer
+            if (!closers.empty() && closers.back() == ']') {
+                cut = i;
+                cut_closers = closers;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (cut == std::string::npos) {
+        return false;
+    }
+    auto text = content.substr(0, cut);
+    text.append(cut_closers.rbegin(), cut_closers.rend());
+    repaired = nlohmann::json::parse(text, nullptr, false);
+    return !repaired.is_discarded();
+}
+
+nlohmann::json ResponseParser::ValueProbabilities(const nlohmann::json& token_logprobs) {
+    auto probabilities = nlohmann::json::array();
+    if (!token_logprobs.is_array()) {
+        return probabilities;
+    }
+
+    // The text of the completion, and the token each of its characters came from
+    std::string text;
+    std::vector<size_t> token_of_char;
+    for (size_t i = 0; i < token_logprobs.size(); i++) {
+        const auto token = token_logprobs[i].value("token", std::string());
+        text += token;
+        token_of_char.insert(token_of_char.end(), token.size(), i);
+    }
+
+    const std::string key = "\"response\"";
+    for (auto position = text.find(key); position != std::string::npos; position = text.find(key, position + 1)) {
+        auto value = position + key.size();
+        while (value < text.size() && (std::isspace(static_cast<unsigned char>(text[value])) || text[value] == ':')) {
+            value++;
+        }
+        if (value >= text.size()) {
+            break;
+        }
+        if (text[value] == 't' || text[value] == 'f') {
+            probabilities.push_back(BooleanProbability(token_logprobs[token_of_char[value]], text[value] == 't'));
+            continue;
+        }
+        // The opening quote of a string is often a token of its own, the answer starts after it
+        if (text[value] == '"' && value + 1 < text.size() && token_of_char[value + 1] != token_of_char[value]) {
+            value++;
+        }
+        const auto& token = token_logprobs[token_of_char[value]];
+        probabilities.push_back(token.contains("logprob") ? std::exp(token["logprob"].get<double>()) : 1.0);
+    }
+    return probabilities;
+}
+
+double ResponseParser::BooleanProbability(const nlohmann::json& token_logprob, const bool chosen) {
+    // Mass of the alternatives spelling true and false, renormalized between the two
+    double true_mass = 0;
+    double false_mass = 0;
+    const auto alternatives = token_logprob.contains("top_logprobs") && token_logprob["top_logprobs"].is_array()
+                                  ? token_logprob["top_logprobs"]
+                                  : nlohmann::json::array({token_logprob});
+    for (const auto& alternative : alternatives) {
+        auto token = alternative.value("token", std::string());
+        token.erase(0, token.find_first_not_of(" \t\n"));
+        if (token.empty() || !alternative.contains("logprob")) {
+            continue;
+        }
+        const auto mass = std::exp(alternative["logprob"].get<double>());
+        if (std::string("true").rfind(token, 0) == 0) {
+            true_mass += mass;
+        } else if (std::string("false").rfind(token, 0) == 0) {
+            false_mass += mass;
+        }
+    }
+    if (true_mass + false_mass <= 0) {
+        return chosen ? 1.0 : 0.0;
+    }
+    return true_mass / (true_mass + false_mass);
+}
+
+std::vector<ResponseParser::AnswerIndex> ResponseParser::MatchAnswers(const nlohmann::json& answers,
+                                                                      const size_t num_tuples, const bool complete) {
+    std::vector<AnswerIndex> matches(num_tuples);
+    size_t values = 0;
+    size_t tagged = 0;
+    for (size_t i = 0; i < answers.size(); i++) {
+        const auto& answer = answers[i];
+        if (!answer.is_object() || !answer.contains("response")) {
+            continue;
+        }
+        const auto value_index = values++;
+        if (!answer.contains("id")) {
+            continue;
+        }
+        tagged++;
+        const auto index = ParseTupleId(answer["id"]);
+        if (index >= 0 && index < static_cast<int64_t>(num_tuples) && matches[index].answer < 0) {
+            matches[index] = {static_cast<int64_t>(i), value_index};
+        }
+    }
+    // A model ignoring the ids altogether can only be trusted when it answered every tuple
+    if (tagged == 0 && complete && answers.size() == num_tuples) {
+        for (size_t i = 0; i < num_tuples; i++) {
+            matches[i] = {static_cast<int64_t>(i), i};
+        }
+    }
+    return matches;
+}
+
+nlohmann::json ResponseParser::IdsToBooleans(const nlohmann::json& ids, const size_t num_tuples) {
+    std::vector<bool> selected(num_tuples, false);
+    if (!ids.is_array()) {
+        throw std::runtime_error("Expected the model to return a list of tuple ids");
+    }
+    for (const auto& id : ids) {
+        const auto index = ParseTupleId(id);
+        // Ids the batch never contained are ignored rather than guessed
+        if (index >= 0 && index < static_cast<int64_t>(num_tuples)) {
+            selected[index] = true;
+        }
+    }
+    auto booleans = nlohmann::json::array();
+    for (const auto is_selected : selected) {
+        booleans.push_back(is_selected);
+    }
+    return booleans;
+}
+
+int64_t ResponseParser::ParseTupleId(const nlohmann::json& id) {
+    if (id.is_number_integer()) {
+        return id.get<int64_t>();
+    }
+    if (id.is_string()) {
+        const auto& text = id.get_ref<const std::string&>();
+        if (!text.empty() && std::all_of(text.begin(), text.end(), ::isdigit)) {
+            return std::stoll(text);
+        }
+    }
+    return -1;
+}
+
+} // namespace flockmtl
@@ -0,0 +1,60 @@
+#include "flockmtl/model_manager/single_flight.hpp"
+#include "flockmtl/core/common.hpp"
+
+#include <chrono>
+
+namespace flockmtl {
+
+SingleFlight& SingleFlight::Get() {
+    static SingleFlight single_flight;
+    return single_flight;
+}
+
+nlohmann::json SingleFlight::Do(const std::string& key, const std::function<nlohmann::json()>& call,
+                                 const std::function<void()>& check_abort) {
+    while (true) {
+        std::promise<nlohmann::json> promise;
+        std::shared_future<nlohmann::json> response;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto entry = inflight_.find(key);
+            if (entry != inflight_.end()) {
+                response = entry->second;
+            } else {
+                inflight_.emplace(key, promise.get_future().share());
+            }
+        }
+
+        if (!response.valid()) {
+            try {
+                auto result = call();
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    inflight_.erase(key);
+                }
+                promise.set_value(result);
+                return result;
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    inflight_.erase(key);
+                }
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+        }
+
+        // The waiter's own query may be cancelled while the shared request is still running
+        while (response.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready) {
+            check_abort();
+        }
+        try {
+            return response.get();
+        } catch (const duckdb::InterruptException&) {
+            // The query that sent the request was cancelled, not this one: send it again
+            check_abort();
+        }
+    }
+}
+
+} // namespace flockmtl
@@ -0,0 +1,41 @@
+#include "flockmtl/model_manager/usage_stats.hpp"
+
+namespace flockmtl {
+
+std::mutex UsageStats::mutex_;
+std::map<std::pair<std::string, std::string>, TokenUsage> UsageStats::usage_;
+
+void UsageStats::Record(const ModelDetails& model_details, const TokenUsage& usage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& total = usage_[{model_details.provider_name, model_details.model}];
+    total.requests += usage.requests;
+    total.input_tokens += usage.input_tokens;
+    total.cached_input_tokens += usage.cached_input_tokens;
+    total.output_tokens += usage.output_tokens;
+}
+
+TokenUsage UsageStats::FromChatCompletion(const nlohmann::json& completion) {
+    TokenUsage usage;
+    usage.requests = 1;
+    if (!completion.contains("usage") || !completion["usage"].is_object()) {
+        return usage;
+    }
+    const auto& reported = completion["usage"];
+    usage.input_tokens = reported.value("prompt_tokens", int64_t(0));
+    usage.output_tokens = reported.value("completion_tokens", int64_t(0));
+    if (reported.contains("prompt_tokens_details") && reported["prompt_tokens_details"].is_object()) {
+        usage.cached_input_tokens = reported["prompt_tokens_details"].value("cached_tokens", int64_t(0));
+    }
+    return usage;
+}
+
+std::vector<UsageStats::Entry> UsageStats::Snapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Entry> entries;
+    for (const auto& [key, usage] : usage_) {
+        entries.push_back({key.first, key.second, usage});
+    }
+    return entries;
+}
+
+} // namespace flockmtl
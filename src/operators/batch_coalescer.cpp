@@ -0,0 +1,65 @@
+#include "flockmtl/operators/batch_coalescer.hpp"
+#include "flockmtl/functions/scalar/scalar.hpp"
+#include "flockmtl/model_manager/tiktoken.hpp"
+
+namespace flockmtl {
+
+BatchCoalescer::BatchCoalescer(Model model, std::string user_prompt, const ScalarFunctionType function_type,
+                               QueryCache* cache)
+    : model_(std::move(model)), user_prompt_(std::move(user_prompt)), function_type_(function_type), cache_(cache),
+      pending_tokens_(model_.GetModelDetails().tuple_format) {
+    const auto num_tokens_meta_and_user_prompt =
+        Tiktoken::GetNumTokens(user_prompt_) + PromptManager::GetStaticTokens(function_type_);
+    const auto available_tokens = model_.GetModelDetails().context_window - num_tokens_meta_and_user_prompt;
+    if (available_tokens < 0) {
+        throw std::runtime_error("The total number of tokens in the prompt exceeds the model's maximum token limit");
+    }
+    available_tokens_ = static_cast<unsigned>(available_tokens);
+}
+
+bool BatchCoalescer::Add(nlohmann::json tuple, std::vector<idx_t> tickets, Batch& full_batch) {
+    auto serialized = tuple.dump();
+    auto duplicate = pending_index_.find(serialized);
+    if (duplicate != pending_index_.end()) {
+        auto& duplicate_tickets = pending_.tickets[duplicate->second];
+        duplicate_tickets.insert(duplicate_tickets.end(), tickets.begin(), tickets.end());
+        return false;
+    }
+
+    auto closed = false;
+    auto measurement = pending_tokens_.Measure(tuple);
+    if (!pending_.tuples.empty() && measurement.tokens > available_tokens_) {
+        closed = Flush(full_batch);
+        // The counter was cleared with the batch, so the tuple is measured against the empty one
+        measurement = pending_tokens_.Measure(tuple);
+    }
+    pending_tokens_.Add(tuple, measurement);
+    pending_index_.emplace(std::move(serialized), pending_.tuples.size());
+    pending_.tuples.push_back(std::move(tuple));
+    pending_.tickets.push_back(std::move(tickets));
+    return closed;
+}
+
+bool BatchCoalescer::Flush(Batch& batch) {
+    if (pending_.tuples.empty()) {
+        return false;
+    }
+    batch = std::move(pending_);
+    pending_ = Batch();
+    pending_index_.clear();
+    pending_tokens_.Clear();
+    return true;
+}
+
+std::vector<nlohmann::json> BatchCoalescer::Complete(const Batch& batch) const {
+    // BatchAndComplete still splits the batch if the responses overflow max_output_tokens
+    auto model = model_;
+    auto responses = ScalarFunctionBase::BatchAndComplete(batch.tuples, user_prompt_, function_type_, model, cache_);
+    if (responses.size() != batch.tuples.size()) {
+        throw std::runtime_error(
+            fmt::format("Expected {} responses from the model but got {}", batch.tuples.size(), responses.size()));
+    }
+    return std::vector<nlohmann::json>(responses.begin(), responses.end());
+}
+
+} // namespace flockmtl
@@ -0,0 +1,26 @@
+#include "flockmtl/operators/llm_filter.hpp"
+
+#include "duckdb/execution/physical_plan_generator.hpp"
+
+namespace flockmtl {
+
+LogicalLlmFilter::LogicalLlmFilter(duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> expressions,
+                                   const idx_t limit)
+    : LogicalExtensionOperator(std::move(expressions)), limit(limit) {}
+
+duckdb::unique_ptr<duckdb::PhysicalOperator>
+LogicalLlmFilter::CreatePlan(duckdb::ClientContext& context, duckdb::PhysicalPlanGenerator& generator) {
+    auto child = generator.CreatePlan(std::move(children[0]));
+
+    auto filter = duckdb::make_uniq<PhysicalLlmFilter>(types, std::move(expressions), limit, estimated_cardinality);
+    filter->children.push_back(std::move(child));
+    return std::move(filter);
+}
+
+duckdb::vector<duckdb::ColumnBinding> LogicalLlmFilter::GetColumnBindings() {
+    return children[0]->GetColumnBindings();
+}
+
+void LogicalLlmFilter::ResolveTypes() { types = children[0]->types; }
+
+} // namespace flockmtl
@@ -0,0 +1,66 @@
+#include "flockmtl/operators/llm_join.hpp"
+
+#include "duckdb/execution/physical_plan_generator.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/expression/bound_reference_expression.hpp"
+#include "duckdb/planner/expression_iterator.hpp"
+
+namespace flockmtl {
+
+namespace {
+
+// The inputs are kept out of `expressions`, which are resolved against the bindings of the last child only, and are
+// resolved here against their own side instead.
+void ResolveInputs(duckdb::unique_ptr<duckdb::Expression>& expression,
+                   const duckdb::vector<duckdb::ColumnBinding>& bindings) {
+    if (expression->GetExpressionClass() != duckdb::ExpressionClass::BOUND_COLUMN_REF) {
+        duckdb::ExpressionIterator::EnumerateChildren(
+            *expression, [&](duckdb::unique_ptr<duckdb::Expression>& child) { ResolveInputs(child, bindings); });
+        return;
+    }
+    const auto& column_ref = expression->Cast<duckdb::BoundColumnRefExpression>();
+    for (idx_t i = 0; i < bindings.size(); i++) {
+        if (bindings[i] == column_ref.binding) {
+            expression =
+                duckdb::make_uniq<duckdb::BoundReferenceExpression>(column_ref.alias, column_ref.return_type, i);
+            return;
+        }
+    }
+    throw duckdb::InternalException("LLM_JOIN input %s is not produced by its side", column_ref.ToString());
+}
+
+} // namespace
+
+LogicalLlmJoin::LogicalLlmJoin(duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> expressions,
+                               std::string embedding_model, const idx_t top_k)
+    : LogicalExtensionOperator(std::move(expressions)), embedding_model(std::move(embedding_model)), top_k(top_k) {}
+
+duckdb::unique_ptr<duckdb::PhysicalOperator>
+LogicalLlmJoin::CreatePlan(duckdb::ClientContext& context, duckdb::PhysicalPlanGenerator& generator) {
+    const auto left_bindings = children[0]->GetColumnBindings();
+    for (auto& input : left_inputs) {
+        ResolveInputs(input, left_bindings);
+    }
+    const auto right_bindings = children[1]->GetColumnBindings();
+    for (auto& input : right_inputs) {
+        ResolveInputs(input, right_bindings);
+    }
+
+    auto left = generator.CreatePlan(std::move(children[0]));
+    auto right = generator.CreatePlan(std::move(children[1]));
+    return duckdb::make_uniq<PhysicalLlmJoin>(*this, std::move(left), std::move(right), estimated_cardinality);
+}
+
+duckdb::vector<duckdb::ColumnBinding> LogicalLlmJoin::GetColumnBindings() {
+    auto bindings = children[0]->GetColumnBindings();
+    auto right_bindings = children[1]->GetColumnBindings();
+    bindings.insert(bindings.end(), right_bindings.begin(), right_bindings.end());
+    return bindings;
+}
+
+void LogicalLlmJoin::ResolveTypes() {
+    types = children[0]->types;
+    types.insert(types.end(), children[1]->types.begin(), children[1]->types.end());
+}
+
+} // namespace flockmtl
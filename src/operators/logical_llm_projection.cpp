@@ -0,0 +1,32 @@
+#include "flockmtl/operators/llm_projection.hpp"
+
+#include "duckdb/execution/physical_plan_generator.hpp"
+
+namespace flockmtl {
+
+LogicalLlmProjection::LogicalLlmProjection(idx_t table_index,
+                                           duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> select_list)
+    : LogicalExtensionOperator(std::move(select_list)), table_index(table_index) {}
+
+duckdb::unique_ptr<duckdb::PhysicalOperator>
+LogicalLlmProjection::CreatePlan(duckdb::ClientContext& context, duckdb::PhysicalPlanGenerator& generator) {
+    auto child = generator.CreatePlan(std::move(children[0]));
+    auto use_batch_index = duckdb::PhysicalPlanGenerator::UseBatchIndex(context, *child);
+
+    auto projection = duckdb::make_uniq<PhysicalLlmProjection>(types, std::move(expressions), estimated_cardinality,
+                                                               use_batch_index);
+    projection->children.push_back(std::move(child));
+    return std::move(projection);
+}
+
+duckdb::vector<duckdb::ColumnBinding> LogicalLlmProjection::GetColumnBindings() {
+    return GenerateColumnBindings(table_index, expressions.size());
+}
+
+void LogicalLlmProjection::ResolveTypes() {
+    for (auto& expression : expressions) {
+        types.push_back(expression->return_type);
+    }
+}
+
+} // namespace flockmtl
@@ -0,0 +1,187 @@
+#include "flockmtl/operators/llm_filter.hpp"
+#include "flockmtl/functions/batch_response_builder.hpp"
+#include "flockmtl/functions/scalar/embedding_prefilter.hpp"
+#include "flockmtl/functions/scalar/llm_filter.hpp"
+#include "flockmtl/operators/batch_coalescer.hpp"
+#include "flockmtl/optimizer/llm_optimizer.hpp"
+
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/planner/expression/bound_conjunction_expression.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+
+#include <atomic>
+
+namespace flockmtl {
+
+namespace {
+
+class LlmFilterGlobalState : public duckdb::GlobalOperatorState {
+public:
+    Model model;
+    std::string user_prompt;
+    ScalarFunctionType function_type;
+    double threshold = LlmFilter::DEFAULT_THRESHOLD;
+    //! Rows that passed the filter across all threads
+    std::atomic<idx_t> selected {0};
+    //! Set once `selected` reached the limit, aborts the requests in flight
+    std::atomic<bool> satisfied {false};
+};
+
+class LlmFilterOperatorState : public duckdb::OperatorState {
+public:
+    LlmFilterOperatorState(duckdb::ExecutionContext& context, const PhysicalLlmFilter& op)
+        : predicate_executor(context.client),
+          tuple_executor(context.client, *op.llm_filter->Cast<duckdb::BoundFunctionExpression>().children[2]),
+          sel(STANDARD_VECTOR_SIZE) {
+        if (op.predicate) {
+            predicate_executor.AddExpression(*op.predicate);
+        }
+    }
+
+    duckdb::ExpressionExecutor predicate_executor;
+    duckdb::ExpressionExecutor tuple_executor;
+    duckdb::SelectionVector sel;
+};
+
+} // namespace
+
+PhysicalLlmFilter::PhysicalLlmFilter(duckdb::vector<duckdb::LogicalType> types,
+                                     duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> expressions,
+                                     const idx_t limit, const idx_t estimated_cardinality)
+    : PhysicalOperator(duckdb::PhysicalOperatorType::EXTENSION, std::move(types), estimated_cardinality),
+      limit(limit) {
+    duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> conjuncts;
+    for (auto& expression : expressions) {
+        if (!llm_filter && LlmOptimizer::IsLlmFunction(*expression)) {
+            llm_filter = std::move(expression);
+        } else {
+            conjuncts.push_back(std::move(expression));
+        }
+    }
+    if (conjuncts.size() == 1) {
+        predicate = std::move(conjuncts[0]);
+    } else if (conjuncts.size() > 1) {
+        auto conjunction =
+            duckdb::make_uniq<duckdb::BoundConjunctionExpression>(duckdb::ExpressionType::CONJUNCTION_AND);
+        conjunction->children = std::move(conjuncts);
+        predicate = std::move(conjunction);
+    }
+}
+
+duckdb::unique_ptr<duckdb::GlobalOperatorState>
+PhysicalLlmFilter::GetGlobalOperatorState(duckdb::ClientContext& context) const {
+    const auto& function = llm_filter->Cast<duckdb::BoundFunctionExpression>();
+    duckdb::Vector model_vector(duckdb::ExpressionExecutor::EvaluateScalar(context, *function.children[0]));
+    duckdb::Vector prompt_vector(duckdb::ExpressionExecutor::EvaluateScalar(context, *function.children[1]));
+
+    auto state = duckdb::make_uniq<LlmFilterGlobalState>();
+    // LIMIT 0 needs no row, no prompt is sent
+    state->satisfied = limit == 0;
+    state->model = Model(CastVectorOfStructsToJson(model_vector, 1)[0]);
+    // Copies of the model share the provider, so reaching the limit anywhere aborts the requests of every thread
+    auto* satisfied = &state->satisfied;
+    state->model.SetAbortCheck([&context, satisfied]() { return context.interrupted.load() || satisfied->load(); });
+    state->user_prompt = PromptManager::CreatePromptDetails(CastVectorOfStructsToJson(prompt_vector, 1)[0]).prompt;
+
+    const auto has_threshold = function.children.size() == 4;
+    state->function_type = LlmFilter::GetFunctionType(context, has_threshold);
+    if (has_threshold) {
+        state->threshold =
+            LlmFilter::GetThreshold(duckdb::ExpressionExecutor::EvaluateScalar(context, *function.children[3]));
+    }
+    return std::move(state);
+}
+
+duckdb::unique_ptr<duckdb::OperatorState>
+PhysicalLlmFilter::GetOperatorState(duckdb::ExecutionContext& context) const {
+    return duckdb::make_uniq<LlmFilterOperatorState>(context, *this);
+}
+
+duckdb::OperatorResultType PhysicalLlmFilter::Execute(duckdb::ExecutionContext& context, duckdb::DataChunk& input,
+                                                      duckdb::DataChunk& chunk, duckdb::GlobalOperatorState& gstate_p,
+                                                      duckdb::OperatorState& state_p) const {
+    auto& gstate = gstate_p.Cast<LlmFilterGlobalState>();
+    auto& state = state_p.Cast<LlmFilterOperatorState>();
+    if (gstate.satisfied) {
+        return duckdb::OperatorResultType::FINISHED;
+    }
+
+    // The model only sees the rows the other conjuncts keep
+    idx_t count = input.size();
+    if (predicate) {
+        count = state.predicate_executor.SelectExpression(input, state.sel);
+    } else {
+        for (idx_t i = 0; i < count; i++) {
+            state.sel.set_index(i, i);
+        }
+    }
+    if (count == 0) {
+        return duckdb::OperatorResultType::NEED_MORE_INPUT;
+    }
+
+    duckdb::DataChunk candidates;
+    candidates.InitializeEmpty(input.GetTypes());
+    candidates.Slice(input, state.sel, count);
+    duckdb::Vector tuple_vector(llm_filter->Cast<duckdb::BoundFunctionExpression>().children[2]->return_type);
+    state.tuple_executor.ExecuteExpression(candidates, tuple_vector);
+    auto tuples = CastVectorOfStructsToJson(tuple_vector, static_cast<int>(count));
+    std::vector<bool> candidate(count, true);
+    if (EmbeddingPrefilter::IsEnabled(context.client)) {
+        auto model = gstate.model;
+        candidate = EmbeddingPrefilter::Apply(context.client, tuples, gstate.user_prompt, gstate.function_type,
+                                              gstate.threshold, model);
+    }
+
+    // One prompt at a time, so the limit is checked between requests instead of after the whole chunk
+    BatchCoalescer coalescer(gstate.model, gstate.user_prompt, gstate.function_type, &QueryCache::Get(context.client));
+    std::vector<bool> keep(count, false);
+    auto evaluate = [&](const BatchCoalescer::Batch& batch) {
+        std::vector<nlohmann::json> responses;
+        try {
+            responses = coalescer.Complete(batch);
+        } catch (const std::exception&) {
+            // Aborted because another thread reached the limit
+            if (gstate.satisfied) {
+                return;
+            }
+            throw;
+        }
+        idx_t passed = 0;
+        for (idx_t i = 0; i < batch.tuples.size(); i++) {
+            if (LlmFilter::IsSelected(responses[i], gstate.threshold)) {
+                for (const auto row : batch.tickets[i]) {
+                    keep[row] = true;
+                }
+                passed += batch.tickets[i].size();
+            }
+        }
+        if (gstate.selected.fetch_add(passed) + passed >= limit) {
+            gstate.satisfied = true;
+        }
+    };
+
+    BatchCoalescer::Batch batch;
+    for (idx_t row = 0; row < count && !gstate.satisfied; row++) {
+        if (candidate[row] && coalescer.Add(std::move(tuples[row]), {row}, batch)) {
+            evaluate(batch);
+        }
+    }
+    if (!gstate.satisfied && coalescer.Flush(batch)) {
+        evaluate(batch);
+    }
+
+    // Rows left unevaluated once the limit is reached are dropped, the LIMIT above has enough rows without them
+    duckdb::SelectionVector result_sel(STANDARD_VECTOR_SIZE);
+    idx_t result_count = 0;
+    for (idx_t row = 0; row < count; row++) {
+        if (keep[row]) {
+            result_sel.set_index(result_count++, state.sel.get_index(row));
+        }
+    }
+    if (result_count > 0) {
+        chunk.Slice(input, result_sel, result_count);
+    }
+    return duckdb::OperatorResultType::NEED_MORE_INPUT;
+}
+
+} // namespace flockmtl
@@ -0,0 +1,307 @@
+#include "flockmtl/operators/llm_join.hpp"
+#include "flockmtl/functions/batch_response_builder.hpp"
+#include "flockmtl/functions/scalar/llm_filter.hpp"
+#include "flockmtl/model_manager/embedding_cache.hpp"
+
+#include "duckdb/common/types/column/column_data_collection.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <queue>
+
+namespace flockmtl {
+
+namespace {
+
+class LlmJoinGlobalSinkState : public duckdb::GlobalSinkState {
+public:
+    Model model;
+    Model embedder;
+    std::string user_prompt;
+    ScalarFunctionType function_type;
+
+    std::mutex lock;
+    duckdb::unique_ptr<duckdb::ColumnDataCollection> rows;
+
+    //! Filled by Finalize: the right rows, where each of them lives, their tuples and their normalized embeddings
+    duckdb::vector<duckdb::unique_ptr<duckdb::DataChunk>> chunks;
+    std::vector<std::pair<idx_t, idx_t>> locations;
+    std::vector<nlohmann::json> tuples;
+    std::vector<float> embeddings;
+    idx_t dimensions = 0;
+};
+
+class LlmJoinLocalSinkState : public duckdb::LocalSinkState {
+public:
+    duckdb::unique_ptr<duckdb::ColumnDataCollection> rows;
+};
+
+class LlmJoinOperatorState : public duckdb::CachingOperatorState {
+public:
+    LlmJoinOperatorState(duckdb::ExecutionContext& context, const PhysicalLlmJoin& op)
+        : executor(context.client, op.left_inputs) {
+        duckdb::vector<duckdb::LogicalType> types;
+        for (const auto& input : op.left_inputs) {
+            types.push_back(input->return_type);
+        }
+        values.Initialize(duckdb::Allocator::Get(context.client), types);
+    }
+
+    duckdb::ExpressionExecutor executor;
+    duckdb::DataChunk values;
+    //! Accepted (left row, right row) pairs of the current input chunk and how many were emitted
+    std::vector<std::pair<idx_t, idx_t>> matches;
+    idx_t emitted = 0;
+    bool evaluated = false;
+};
+
+std::vector<nlohmann::json> InputsToJson(duckdb::DataChunk& values, const duckdb::vector<std::string>& names) {
+    duckdb::child_list_t<duckdb::LogicalType> fields;
+    for (idx_t i = 0; i < names.size(); i++) {
+        fields.emplace_back(names[i], values.data[i].GetType());
+    }
+    duckdb::Vector tuples(duckdb::LogicalType::STRUCT(fields), values.size());
+    auto& entries = duckdb::StructVector::GetEntries(tuples);
+    for (idx_t i = 0; i < names.size(); i++) {
+        entries[i]->Reference(values.data[i]);
+    }
+    return CastVectorOfStructsToJson(tuples, static_cast<int>(values.size()));
+}
+
+std::vector<float> Normalize(const std::vector<float>& embedding) {
+    double norm = 0;
+    for (const auto value : embedding) {
+        norm += static_cast<double>(value) * value;
+    }
+    norm = norm > 0 ? std::sqrt(norm) : 1;
+    std::vector<float> normalized;
+    normalized.reserve(embedding.size());
+    for (const auto value : embedding) {
+        normalized.push_back(static_cast<float>(value / norm));
+    }
+    return normalized;
+}
+
+std::vector<std::vector<float>> EmbedTuples(Model& embedder, const std::vector<nlohmann::json>& tuples) {
+    std::vector<std::string> texts;
+    texts.reserve(tuples.size());
+    for (const auto& tuple : tuples) {
+        texts.push_back(EmbeddingCache::TupleText(tuple));
+    }
+    return EmbeddingCache::Get().Embed(embedder, texts);
+}
+
+} // namespace
+
+PhysicalLlmJoin::PhysicalLlmJoin(LogicalLlmJoin& op, duckdb::unique_ptr<duckdb::PhysicalOperator> left,
+                                 duckdb::unique_ptr<duckdb::PhysicalOperator> right, const idx_t estimated_cardinality)
+    : PhysicalJoin(op, duckdb::PhysicalOperatorType::EXTENSION, duckdb::JoinType::INNER, estimated_cardinality),
+      model(std::move(op.expressions[0])), prompt(std::move(op.expressions[1])),
+      left_inputs(std::move(op.left_inputs)), left_names(std::move(op.left_names)),
+      right_inputs(std::move(op.right_inputs)), right_names(std::move(op.right_names)),
+      embedding_model(std::move(op.embedding_model)), top_k(op.top_k) {
+    children.push_back(std::move(left));
+    children.push_back(std::move(right));
+}
+
+duckdb::unique_ptr<duckdb::GlobalSinkState>
+PhysicalLlmJoin::GetGlobalSinkState(duckdb::ClientContext& context) const {
+    duckdb::Vector model_vector(duckdb::ExpressionExecutor::EvaluateScalar(context, *model));
+    duckdb::Vector prompt_vector(duckdb::ExpressionExecutor::EvaluateScalar(context, *prompt));
+
+    auto state = duckdb::make_uniq<LlmJoinGlobalSinkState>();
+    state->model = Model(CastVectorOfStructsToJson(model_vector, 1)[0]);
+    state->model.SetInterruptFlag(context.interrupted);
+    state->embedder = Model(nlohmann::json {{"model_name", embedding_model}});
+    state->embedder.SetInterruptFlag(context.interrupted);
+    state->user_prompt = PromptManager::CreatePromptDetails(CastVectorOfStructsToJson(prompt_vector, 1)[0]).prompt;
+    state->function_type = LlmFilter::GetFunctionType(context, false);
+    state->rows = duckdb::make_uniq<duckdb::ColumnDataCollection>(duckdb::BufferManager::GetBufferManager(context),
+                                                                  children[1]->types);
+    return std::move(state);
+}
+
+duckdb::unique_ptr<duckdb::LocalSinkState> PhysicalLlmJoin::GetLocalSinkState(duckdb::ExecutionContext& context) const {
+    auto state = duckdb::make_uniq<LlmJoinLocalSinkState>();
+    state->rows = duckdb::make_uniq<duckdb::ColumnDataCollection>(
+        duckdb::BufferManager::GetBufferManager(context.client), children[1]->types);
+    return std::move(state);
+}
+
+duckdb::SinkResultType PhysicalLlmJoin::Sink(duckdb::ExecutionContext& context, duckdb::DataChunk& chunk,
+                                             duckdb::OperatorSinkInput& input) const {
+    input.local_state.Cast<LlmJoinLocalSinkState>().rows->Append(chunk);
+    return duckdb::SinkResultType::NEED_MORE_INPUT;
+}
+
+duckdb::SinkCombineResultType PhysicalLlmJoin::Combine(duckdb::ExecutionContext& context,
+                                                       duckdb::OperatorSinkCombineInput& input) const {
+    auto& gstate = input.global_state.Cast<LlmJoinGlobalSinkState>();
+    auto& lstate = input.local_state.Cast<LlmJoinLocalSinkState>();
+    std::lock_guard<std::mutex> guard(gstate.lock);
+    gstate.rows->Combine(*lstate.rows);
+    return duckdb::SinkCombineResultType::FINISHED;
+}
+
+duckdb::SinkFinalizeType PhysicalLlmJoin::Finalize(duckdb::Pipeline& pipeline, duckdb::Event& event,
+                                                   duckdb::ClientContext& context,
+                                                   duckdb::OperatorSinkFinalizeInput& input) const {
+    auto& gstate = input.global_state.Cast<LlmJoinGlobalSinkState>();
+    if (gstate.rows->Count() == 0) {
+        return duckdb::SinkFinalizeType::NO_OUTPUT_POSSIBLE;
+    }
+
+    duckdb::ExpressionExecutor executor(context, right_inputs);
+    duckdb::vector<duckdb::LogicalType> types;
+    for (const auto& input_expression : right_inputs) {
+        types.push_back(input_expression->return_type);
+    }
+    duckdb::DataChunk values;
+    values.Initialize(duckdb::Allocator::Get(context), types);
+    for (auto& chunk : gstate.rows->Chunks()) {
+        auto copy = duckdb::make_uniq<duckdb::DataChunk>();
+        copy->Initialize(duckdb::Allocator::Get(context), chunk.GetTypes());
+        chunk.Copy(*copy);
+        for (idx_t row = 0; row < copy->size(); row++) {
+            gstate.locations.emplace_back(gstate.chunks.size(), row);
+        }
+
+        values.Reset();
+        executor.Execute(*copy, values);
+        auto tuples = InputsToJson(values, right_names);
+        gstate.tuples.insert(gstate.tuples.end(), tuples.begin(), tuples.end());
+        gstate.chunks.push_back(std::move(copy));
+    }
+
+    // Stored contiguously and normalized, the blocking of every left row is a scan of dot products
+    auto embeddings = EmbedTuples(gstate.embedder, gstate.tuples);
+    gstate.dimensions = embeddings.empty() ? 0 : embeddings[0].size();
+    gstate.embeddings.reserve(embeddings.size() * gstate.dimensions);
+    for (const auto& embedding : embeddings) {
+        if (embedding.size() != gstate.dimensions) {
+            throw std::runtime_error("The embedding model returned embeddings of different sizes.");
+        }
+        auto normalized = Normalize(embedding);
+        gstate.embeddings.insert(gstate.embeddings.end(), normalized.begin(), normalized.end());
+    }
+    return duckdb::SinkFinalizeType::READY;
+}
+
+duckdb::unique_ptr<duckdb::OperatorState> PhysicalLlmJoin::GetOperatorState(duckdb::ExecutionContext& context) const {
+    return duckdb::make_uniq<LlmJoinOperatorState>(context, *this);
+}
+
+duckdb::OperatorResultType PhysicalLlmJoin::ExecuteInternal(duckdb::ExecutionContext& context,
+                                                            duckdb::DataChunk& input, duckdb::DataChunk& chunk,
+                                                            duckdb::GlobalOperatorState& gstate_p,
+                                                            duckdb::OperatorState& state_p) const {
+    auto& sink = sink_state->Cast<LlmJoinGlobalSinkState>();
+    auto& state = state_p.Cast<LlmJoinOperatorState>();
+
+    if (!state.evaluated) {
+        state.evaluated = true;
+        state.matches.clear();
+        state.emitted = 0;
+
+        state.values.Reset();
+        state.executor.Execute(input, state.values);
+        auto left_tuples = InputsToJson(state.values, left_names);
+        auto embedder = sink.embedder;
+        auto left_embeddings = EmbedTuples(embedder, left_tuples);
+
+        // Blocking: every left row is only paired with the top_k right rows closest to it
+        const auto right_count = sink.tuples.size();
+        std::vector<nlohmann::json> pairs;
+        std::vector<std::pair<idx_t, idx_t>> candidates;
+        for (idx_t row = 0; row < left_tuples.size(); row++) {
+            if (left_embeddings[row].size() != sink.dimensions) {
+                throw std::runtime_error("The embedding model returned embeddings of different sizes.");
+            }
+            const auto embedding = Normalize(left_embeddings[row]);
+            std::priority_queue<std::pair<float, idx_t>, std::vector<std::pair<float, idx_t>>, std::greater<>> closest;
+            for (idx_t right = 0; right < right_count; right++) {
+                const auto* right_embedding = sink.embeddings.data() + right * sink.dimensions;
+                float similarity = 0;
+                for (idx_t d = 0; d < sink.dimensions; d++) {
+                    similarity += embedding[d] * right_embedding[d];
+                }
+                if (closest.size() < top_k) {
+                    closest.emplace(similarity, right);
+                } else if (similarity > closest.top().first) {
+                    closest.pop();
+                    closest.emplace(similarity, right);
+                }
+            }
+            for (; !closest.empty(); closest.pop()) {
+                const auto right = closest.top().second;
+                auto pair = left_tuples[row];
+                for (const auto& item : sink.tuples[right].items()) {
+                    pair[item.key()] = item.value();
+                }
+                pairs.push_back(std::move(pair));
+                candidates.emplace_back(row, right);
+            }
+        }
+
+        // Many pairs per prompt, and a pair met again in the query is answered from the query cache
+        auto model = sink.model;
+        auto responses = ScalarFunctionBase::BatchAndComplete(pairs, sink.user_prompt, sink.function_type, model,
+                                                              &QueryCache::Get(context.client));
+        if (responses.size() != candidates.size()) {
+            throw std::runtime_error(fmt::format("Expected {} responses from the model but got {}", candidates.size(),
+                                                 responses.size()));
+        }
+        for (idx_t i = 0; i < candidates.size(); i++) {
+            if (LlmFilter::IsSelected(responses[i], LlmFilter::DEFAULT_THRESHOLD)) {
+                state.matches.push_back(candidates[i]);
+            }
+        }
+        // The right rows are numbered in the order of their chunks, so the matches of one right chunk are adjacent
+        // and its columns are copied with one selection each
+        std::sort(state.matches.begin(), state.matches.end(),
+                  [](const std::pair<idx_t, idx_t>& lhs, const std::pair<idx_t, idx_t>& rhs) {
+                      return lhs.second < rhs.second;
+                  });
+    }
+
+    const auto count = std::min<idx_t>(STANDARD_VECTOR_SIZE, state.matches.size() - state.emitted);
+    if (count > 0) {
+        duckdb::SelectionVector left_sel(STANDARD_VECTOR_SIZE);
+        for (idx_t i = 0; i < count; i++) {
+            left_sel.set_index(i, state.matches[state.emitted + i].first);
+        }
+        const auto left_columns = input.ColumnCount();
+        for (idx_t c = 0; c < left_columns; c++) {
+            chunk.data[c].Slice(input.data[c], left_sel, count);
+        }
+        duckdb::SelectionVector right_sel(STANDARD_VECTOR_SIZE);
+        for (idx_t start = 0, end = 0; start < count; start = end) {
+            const auto right_chunk_index = sink.locations[state.matches[state.emitted + start].second].first;
+            for (; end < count; end++) {
+                const auto& location = sink.locations[state.matches[state.emitted + end].second];
+                if (location.first != right_chunk_index) {
+                    break;
+                }
+                right_sel.set_index(end - start, location.second);
+            }
+            auto& right_chunk = *sink.chunks[right_chunk_index];
+            for (idx_t c = 0; c < right_chunk.ColumnCount(); c++) {
+                duckdb::VectorOperations::Copy(right_chunk.data[c], chunk.data[left_columns + c], right_sel,
+                                               end - start, 0, start);
+            }
+        }
+        chunk.SetCardinality(count);
+        state.emitted += count;
+    }
+    if (state.emitted < state.matches.size()) {
+        return duckdb::OperatorResultType::HAVE_MORE_OUTPUT;
+    }
+    state.evaluated = false;
+    return duckdb::OperatorResultType::NEED_MORE_INPUT;
+}
+
+} // namespace flockmtl
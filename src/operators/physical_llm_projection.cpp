@@ -0,0 +1,635 @@
+#include "flockmtl/operators/llm_projection.hpp"
+#include "flockmtl/core/config.hpp"
+#include "flockmtl/core/io_reactor.hpp"
+#include "flockmtl/functions/batch_response_builder.hpp"
+#include "flockmtl/functions/scalar/embedding_prefilter.hpp"
+#include "flockmtl/functions/scalar/llm_filter.hpp"
+#include "flockmtl/functions/scalar/llm_filter_score.hpp"
+#include "flockmtl/operators/batch_coalescer.hpp"
+#include "flockmtl/optimizer/llm_optimizer.hpp"
+
+#include "duckdb/common/error_data.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/parallel/interrupt.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace flockmtl {
+
+namespace {
+
+struct ProjectedChunk {
+    idx_t batch_index;
+    idx_t sequence;
+    duckdb::unique_ptr<duckdb::DataChunk> input;
+    duckdb::unique_ptr<duckdb::DataChunk> output;
+    //! Pending pieces of work: one per coalesced row, one for the per-chunk evaluation, one held by the sink
+    idx_t outstanding = 1;
+    bool ready = false;
+};
+
+struct CoalescedColumn {
+    idx_t column;
+    //! llm_filter columns are BOOLEAN, their responses are decided against the threshold
+    bool is_filter = false;
+    double threshold = LlmFilter::DEFAULT_THRESHOLD;
+    //! llm_filter_score columns are DOUBLE, the probability of the filter holding
+    bool is_score = false;
+    //! Key of the column's answer within the responses of a fused call, empty when the call is not fused
+    std::string key;
+
+    nlohmann::json Answer(const nlohmann::json& response) const {
+        if (key.empty()) {
+            return response;
+        }
+        return response.is_object() && response.contains(key) ? response[key] : nlohmann::json();
+    }
+
+    // Must hold the shared lock, the string heap of the output vector is not thread safe.
+    void Write(const nlohmann::json& response, const std::string& serialized, duckdb::Vector& result,
+               const idx_t row) const {
+        if (is_filter) {
+            duckdb::FlatVector::GetData<bool>(result)[row] = LlmFilter::IsSelected(response, threshold);
+        } else if (is_score) {
+            duckdb::FlatVector::GetData<double>(result)[row] = LlmFilterScore::GetScore(response);
+        } else {
+            duckdb::FlatVector::GetData<duckdb::string_t>(result)[row] =
+                duckdb::StringVector::AddString(result, serialized);
+        }
+    }
+};
+
+// One request stream, answering one column or, when fused, several columns over the same tuples.
+struct CoalescedCall {
+    duckdb::vector<CoalescedColumn> columns;
+    duckdb::unique_ptr<BatchCoalescer> coalescer;
+    //! Index of the tuple expression the call reads, calls split out of one fusable group share it
+    idx_t tuples = 0;
+    //! Set for a lone llm_filter column when the embedding pre-filter is on, the tuples it rejects are answered
+    //! false without reaching the coalescer
+    bool prefilter = false;
+    Model model;
+    std::string user_prompt;
+    ScalarFunctionType function_type = ScalarFunctionType::FILTER;
+
+    void EnablePrefilter(const Model& call_model, const std::pair<std::string, ScalarFunctionType>& task) {
+        prefilter = true;
+        model = call_model;
+        user_prompt = task.first;
+        function_type = task.second;
+    }
+};
+
+struct PendingBatch {
+    idx_t coalesced_index;
+    BatchCoalescer::Batch batch;
+};
+
+// Shared between the pipeline tasks and the reactor threads, kept alive by whichever finishes last.
+struct LlmProjectionShared {
+    std::mutex lock;
+    std::condition_variable drained;
+    duckdb::vector<duckdb::unique_ptr<ProjectedChunk>> chunks;
+    duckdb::vector<ProjectedChunk*> chunks_by_sequence;
+    //! Chunks sunk but not ready yet
+    idx_t inflight = 0;
+    //! Reactor tasks submitted but not finished yet
+    idx_t running = 0;
+    std::atomic<bool> cancelled {false};
+    duckdb::ErrorData error;
+    //! Sink and source tasks parked until a chunk becomes ready
+    duckdb::vector<duckdb::InterruptState> blocked_tasks;
+
+    //! LLM expressions evaluated chunk by chunk
+    duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> llm_expressions;
+    duckdb::vector<idx_t> llm_columns;
+    //! LLM calls whose tuples are packed across chunks
+    duckdb::vector<CoalescedCall> coalesced;
+
+    // Must hold the lock.
+    void FinishWork(ProjectedChunk& chunk, const idx_t pieces, duckdb::vector<duckdb::InterruptState>& to_wake) {
+        chunk.outstanding -= pieces;
+        if (chunk.outstanding > 0) {
+            return;
+        }
+        chunk.ready = true;
+        inflight--;
+        for (auto& task : blocked_tasks) {
+            to_wake.push_back(std::move(task));
+        }
+        blocked_tasks.clear();
+    }
+
+    // Must hold the lock, the batches are submitted by the caller once it is released.
+    void FlushAll(std::vector<PendingBatch>& batches) {
+        for (idx_t i = 0; i < coalesced.size(); i++) {
+            BatchCoalescer::Batch batch;
+            if (coalesced[i].coalescer->Flush(batch)) {
+                batches.push_back({i, std::move(batch)});
+                running++;
+            }
+        }
+    }
+
+    void SetError(const std::exception& ex) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!error.HasError()) {
+            error = duckdb::ErrorData(ex);
+        }
+    }
+
+    void Release(duckdb::vector<duckdb::InterruptState>& to_wake) {
+        drained.notify_all();
+        for (auto& task : to_wake) {
+            task.Callback();
+        }
+    }
+};
+
+idx_t MakeTicket(const idx_t sequence, const idx_t row) { return sequence * STANDARD_VECTOR_SIZE + row; }
+
+// Finishes the work a reactor task stands for and leaves `running` however the task ends, so neither the source
+// nor the sink state waits on it forever.
+class ReactorTaskGuard {
+public:
+    ReactorTaskGuard(LlmProjectionShared& shared, ProjectedChunk* chunk, const PendingBatch* pending)
+        : shared(shared), chunk(chunk), pending(pending) {}
+
+    ~ReactorTaskGuard() {
+        duckdb::vector<duckdb::InterruptState> to_wake;
+        {
+            std::lock_guard<std::mutex> guard(shared.lock);
+            if (chunk) {
+                shared.FinishWork(*chunk, 1, to_wake);
+            }
+            if (pending) {
+                for (const auto& tickets : pending->batch.tickets) {
+                    for (const auto ticket : tickets) {
+                        shared.FinishWork(*shared.chunks_by_sequence[ticket / STANDARD_VECTOR_SIZE], 1, to_wake);
+                    }
+                }
+            }
+            shared.running--;
+        }
+        shared.Release(to_wake);
+    }
+
+private:
+    LlmProjectionShared& shared;
+    ProjectedChunk* chunk;
+    const PendingBatch* pending;
+};
+
+void EvaluateChunk(LlmProjectionShared& shared, duckdb::ClientContext& context, ProjectedChunk& chunk) {
+    ReactorTaskGuard task_guard(shared, &chunk, nullptr);
+    try {
+        if (!shared.cancelled && !context.interrupted) {
+            duckdb::ExpressionExecutor executor(context, shared.llm_expressions);
+            executor.SetChunk(chunk.input.get());
+            for (idx_t i = 0; i < shared.llm_columns.size(); i++) {
+                executor.ExecuteExpression(i, chunk.output->data[shared.llm_columns[i]]);
+            }
+        }
+    } catch (std::exception& ex) {
+        shared.SetError(ex);
+    } catch (...) {
+        shared.SetError(std::runtime_error("Unknown error while evaluating an LLM projection"));
+    }
+}
+
+void EvaluateBatch(LlmProjectionShared& shared, duckdb::ClientContext& context, const PendingBatch& pending) {
+    ReactorTaskGuard task_guard(shared, nullptr, &pending);
+    try {
+        if (shared.cancelled || context.interrupted) {
+            return;
+        }
+        const auto responses = shared.coalesced[pending.coalesced_index].coalescer->Complete(pending.batch);
+
+        // Serialized once per tuple and outside the lock, rows sharing the tuple copy the same string
+        const auto& call = shared.coalesced[pending.coalesced_index];
+        std::vector<std::vector<nlohmann::json>> answers(call.columns.size());
+        std::vector<std::vector<std::string>> serialized(call.columns.size());
+        for (idx_t c = 0; c < call.columns.size(); c++) {
+            serialized[c].resize(responses.size());
+            for (idx_t i = 0; i < responses.size(); i++) {
+                answers[c].push_back(call.columns[c].Answer(responses[i]));
+                if (!call.columns[c].is_filter && !call.columns[c].is_score) {
+                    serialized[c][i] = answers[c][i].dump();
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(shared.lock);
+        for (idx_t i = 0; i < pending.batch.tuples.size() && i < responses.size(); i++) {
+            for (const auto ticket : pending.batch.tickets[i]) {
+                auto& chunk = *shared.chunks_by_sequence[ticket / STANDARD_VECTOR_SIZE];
+                for (idx_t c = 0; c < call.columns.size(); c++) {
+                    const auto& column = call.columns[c];
+                    column.Write(answers[c][i], serialized[c][i], chunk.output->data[column.column],
+                                 ticket % STANDARD_VECTOR_SIZE);
+                }
+            }
+        }
+    } catch (std::exception& ex) {
+        shared.SetError(ex);
+    } catch (...) {
+        shared.SetError(std::runtime_error("Unknown error while evaluating an LLM projection"));
+    }
+}
+
+void SubmitBatches(const std::shared_ptr<LlmProjectionShared>& shared, duckdb::ClientContext& context,
+                   std::vector<PendingBatch>& batches) {
+    for (auto& batch : batches) {
+        auto task = std::make_shared<PendingBatch>(std::move(batch));
+        IoReactor::Get().Submit([shared, &context, task]() { EvaluateBatch(*shared, context, *task); });
+    }
+    batches.clear();
+}
+
+class LlmProjectionGlobalSinkState : public duckdb::GlobalSinkState {
+public:
+    LlmProjectionGlobalSinkState() : shared(std::make_shared<LlmProjectionShared>()) {}
+
+    ~LlmProjectionGlobalSinkState() override {
+        // The reactor tasks reference the client context, they must not outlive the query
+        shared->cancelled = true;
+        std::unique_lock<std::mutex> guard(shared->lock);
+        shared->drained.wait(guard, [this] { return shared->running == 0; });
+    }
+
+    std::shared_ptr<LlmProjectionShared> shared;
+};
+
+class LlmProjectionLocalSinkState : public duckdb::LocalSinkState {
+public:
+    LlmProjectionLocalSinkState(duckdb::ClientContext& context, const PhysicalLlmProjection& op) : executor(context) {
+        for (idx_t i = 0; i < op.select_list.size(); i++) {
+            if (!op.is_llm_expression[i]) {
+                executor.AddExpression(*op.select_list[i]);
+            }
+        }
+        // The tuples of coalesced calls are cheap to compute, only the model call is deferred. Fused calls share
+        // the tuples of the first one.
+        for (idx_t i = 0; i < op.select_list.size(); i++) {
+            if (op.is_coalesced[i] && op.fused_with[i] == i) {
+                const auto& tuple = *op.select_list[i]->Cast<duckdb::BoundFunctionExpression>().children[2];
+                executor.AddExpression(tuple);
+                tuple_types.push_back(tuple.return_type);
+            }
+        }
+    }
+
+    duckdb::ExpressionExecutor executor;
+    duckdb::vector<duckdb::LogicalType> tuple_types;
+};
+
+class LlmProjectionSourceState : public duckdb::GlobalSourceState {
+public:
+    idx_t next_chunk = 0;
+};
+
+} // namespace
+
+PhysicalLlmProjection::PhysicalLlmProjection(duckdb::vector<duckdb::LogicalType> types,
+                                             duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> select_list,
+                                             idx_t estimated_cardinality, bool use_batch_index)
+    : PhysicalOperator(duckdb::PhysicalOperatorType::EXTENSION, std::move(types), estimated_cardinality),
+      select_list(std::move(select_list)), use_batch_index(use_batch_index) {
+    for (idx_t i = 0; i < this->select_list.size(); i++) {
+        const auto& expression = *this->select_list[i];
+        is_llm_expression.push_back(LlmOptimizer::ContainsLlmFunction(expression));
+        is_coalesced.push_back(CanCoalesce(expression));
+        fused_with.push_back(i);
+        if (!is_coalesced[i]) {
+            continue;
+        }
+        for (idx_t j = 0; j < i; j++) {
+            if (is_coalesced[j] && fused_with[j] == j && CanFuse(*this->select_list[j], expression)) {
+                fused_with[i] = j;
+                break;
+            }
+        }
+    }
+}
+
+bool PhysicalLlmProjection::CanFuse(const duckdb::Expression& lhs, const duckdb::Expression& rhs) {
+    const auto& lhs_function = lhs.Cast<duckdb::BoundFunctionExpression>();
+    const auto& rhs_function = rhs.Cast<duckdb::BoundFunctionExpression>();
+    // The probabilities come from the log probabilities of a plain boolean answer, a fused JSON object has none
+    if (lhs_function.function.name == "llm_filter_score" || rhs_function.function.name == "llm_filter_score") {
+        return false;
+    }
+    return lhs_function.children[0]->Equals(*rhs_function.children[0]) &&
+           lhs_function.children[2]->Equals(*rhs_function.children[2]);
+}
+
+bool PhysicalLlmProjection::CanCoalesce(const duckdb::Expression& expression) {
+    if (!LlmOptimizer::IsLlmFunction(expression)) {
+        return false;
+    }
+    const auto& function = expression.Cast<duckdb::BoundFunctionExpression>();
+    if (function.function.name == "llm_embedding" || function.children.size() < 3) {
+        return false;
+    }
+    // Only llm_filter takes a fourth argument, its threshold
+    if (function.children.size() > 3 &&
+        (function.function.name != "llm_filter" || function.children.size() != 4 ||
+         !function.children[3]->IsFoldable())) {
+        return false;
+    }
+    return function.children[0]->IsFoldable() && function.children[1]->IsFoldable() &&
+           !LlmOptimizer::ContainsLlmFunction(*function.children[2]);
+}
+
+duckdb::unique_ptr<duckdb::GlobalSinkState>
+PhysicalLlmProjection::GetGlobalSinkState(duckdb::ClientContext& context) const {
+    auto state = duckdb::make_uniq<LlmProjectionGlobalSinkState>();
+    auto& shared = *state->shared;
+    idx_t tuples = 0;
+    for (idx_t i = 0; i < select_list.size(); i++) {
+        if (is_llm_expression[i] && !is_coalesced[i]) {
+            shared.llm_expressions.push_back(select_list[i]->Copy());
+            shared.llm_columns.push_back(i);
+        }
+        if (!is_coalesced[i] || fused_with[i] != i) {
+            continue;
+        }
+
+        const auto& function = select_list[i]->Cast<duckdb::BoundFunctionExpression>();
+        duckdb::Vector model_vector(duckdb::ExpressionExecutor::EvaluateScalar(context, *function.children[0]));
+        Model model(CastVectorOfStructsToJson(model_vector, 1)[0]);
+        // A torn down operator aborts its in-flight transfers too, the destructor waits for them
+        auto* cancelled = &shared.cancelled;
+        model.SetAbortCheck([&context, cancelled]() { return context.interrupted.load() || cancelled->load(); });
+
+        CoalescedCall call;
+        std::vector<std::pair<std::string, ScalarFunctionType>> tasks;
+        for (idx_t j = i; j < select_list.size(); j++) {
+            if (!is_coalesced[j] || fused_with[j] != i) {
+                continue;
+            }
+            const auto& fused = select_list[j]->Cast<duckdb::BoundFunctionExpression>();
+            duckdb::Vector prompt_vector(duckdb::ExpressionExecutor::EvaluateScalar(context, *fused.children[1]));
+            auto prompt_details = PromptManager::CreatePromptDetails(CastVectorOfStructsToJson(prompt_vector, 1)[0]);
+            CoalescedColumn column;
+            column.column = j;
+            column.is_filter = fused.function.name == "llm_filter";
+            column.is_score = fused.function.name == "llm_filter_score";
+            auto function_type = fused.function.name == "llm_complete_json" ? ScalarFunctionType::COMPLETE_JSON
+                                                                            : ScalarFunctionType::COMPLETE;
+            if (column.is_score) {
+                function_type = ScalarFunctionType::FILTER_PROBABILITY;
+            }
+            if (column.is_filter) {
+                const auto has_threshold = fused.children.size() == 4;
+                if (has_threshold) {
+                    column.threshold = LlmFilter::GetThreshold(
+                        duckdb::ExpressionExecutor::EvaluateScalar(context, *fused.children[3]));
+                }
+                function_type = LlmFilter::GetFunctionType(context, has_threshold);
+            }
+            call.columns.push_back(std::move(column));
+            tasks.emplace_back(std::move(prompt_details.prompt), function_type);
+        }
+
+        call.tuples = tuples++;
+        // A fused call still needs the rejected tuples for its other columns, so only lone filters are pre-filtered
+        const auto prefilter = EmbeddingPrefilter::IsEnabled(context);
+        if (tasks.size() > 1 && !model.GetModelDetails().cascade.empty()) {
+            // A fused call answers with one JSON object, which a cascade cannot escalate column by column. The
+            // columns keep their shared tuples but each gets its own request stream.
+            for (idx_t c = 0; c < call.columns.size(); c++) {
+                CoalescedCall single;
+                single.columns.push_back(std::move(call.columns[c]));
+                single.tuples = call.tuples;
+                if (prefilter && single.columns[0].is_filter) {
+                    single.EnablePrefilter(model, tasks[c]);
+                }
+                single.coalescer = duckdb::make_uniq<BatchCoalescer>(model, tasks[c].first, tasks[c].second,
+                                                                     &QueryCache::Get(context));
+                shared.coalesced.push_back(std::move(single));
+            }
+            continue;
+        }
+        if (tasks.size() == 1) {
+            if (prefilter && call.columns[0].is_filter) {
+                call.EnablePrefilter(model, tasks[0]);
+            }
+            call.coalescer = duckdb::make_uniq<BatchCoalescer>(std::move(model), tasks[0].first, tasks[0].second,
+                                                               &QueryCache::Get(context));
+        } else {
+            // The tuples are sent once and every call's answer comes back as one key of a JSON object
+            for (idx_t c = 0; c < call.columns.size(); c++) {
+                call.columns[c].key = PromptManager::FusedTaskKey(c);
+            }
+            call.coalescer = duckdb::make_uniq<BatchCoalescer>(std::move(model), PromptManager::FusePrompts(tasks),
+                                                               ScalarFunctionType::COMPLETE_JSON,
+                                                               &QueryCache::Get(context));
+        }
+        shared.coalesced.push_back(std::move(call));
+    }
+    return std::move(state);
+}
+
+duckdb::unique_ptr<duckdb::LocalSinkState>
+PhysicalLlmProjection::GetLocalSinkState(duckdb::ExecutionContext& context) const {
+    return duckdb::make_uniq<LlmProjectionLocalSinkState>(context.client, *this);
+}
+
+duckdb::SinkResultType PhysicalLlmProjection::Sink(duckdb::ExecutionContext& context, duckdb::DataChunk& chunk,
+                                                   duckdb::OperatorSinkInput& input) const {
+    auto& gstate = input.global_state.Cast<LlmProjectionGlobalSinkState>();
+    auto& lstate = input.local_state.Cast<LlmProjectionLocalSinkState>();
+    auto& shared = *gstate.shared;
+
+    std::vector<PendingBatch> batches;
+    ProjectedChunk* projected = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(shared.lock);
+        if (shared.error.HasError()) {
+            shared.error.Throw();
+        }
+        if (shared.inflight >= static_cast<idx_t>(Config::default_max_inflight_chunks)) {
+            // Partial batches may be what the in-flight chunks are waiting on
+            shared.FlushAll(batches);
+            shared.blocked_tasks.push_back(input.interrupt_state);
+        } else {
+            auto entry = duckdb::make_uniq<ProjectedChunk>();
+            entry->batch_index = use_batch_index ? input.local_state.partition_info.batch_index.GetIndex() : 0;
+            entry->sequence = shared.chunks_by_sequence.size();
+            projected = entry.get();
+            shared.chunks_by_sequence.push_back(projected);
+            shared.chunks.push_back(std::move(entry));
+            shared.inflight++;
+        }
+    }
+    if (!projected) {
+        SubmitBatches(gstate.shared, context.client, batches);
+        return duckdb::SinkResultType::BLOCKED;
+    }
+
+    duckdb::DataChunk tuples;
+    std::vector<DistinctTuples> tuples_json;
+    std::vector<std::vector<std::vector<idx_t>>> tuples_tickets;
+    // Per coalesced call, whether each tuple goes on to the model, empty when the call is not pre-filtered
+    std::vector<std::vector<bool>> candidates(shared.coalesced.size());
+    try {
+        auto& allocator = duckdb::Allocator::Get(context.client);
+        projected->input = duckdb::make_uniq<duckdb::DataChunk>();
+        projected->input->Initialize(allocator, chunk.GetTypes());
+        chunk.Copy(*projected->input);
+        projected->output = duckdb::make_uniq<duckdb::DataChunk>();
+        projected->output->Initialize(allocator, types);
+
+        lstate.executor.SetChunk(projected->input.get());
+        idx_t executor_index = 0;
+        for (idx_t i = 0; i < select_list.size(); i++) {
+            if (!is_llm_expression[i]) {
+                lstate.executor.ExecuteExpression(executor_index++, projected->output->data[i]);
+            }
+        }
+        projected->output->SetCardinality(*projected->input);
+
+        if (!lstate.tuple_types.empty()) {
+            tuples.Initialize(allocator, lstate.tuple_types);
+            for (idx_t i = 0; i < lstate.tuple_types.size(); i++) {
+                lstate.executor.ExecuteExpression(executor_index++, tuples.data[i]);
+            }
+            tuples.SetCardinality(*projected->input);
+            for (idx_t i = 0; i < lstate.tuple_types.size(); i++) {
+                tuples_json.push_back(CastVectorOfStructsToDistinctJson(tuples.data[i], tuples.size()));
+                std::vector<std::vector<idx_t>> tickets(tuples_json.back().tuples.size());
+                for (idx_t row = 0; row < tuples.size(); row++) {
+                    tickets[tuples_json.back().row_to_tuple[row]].push_back(MakeTicket(projected->sequence, row));
+                }
+                tuples_tickets.push_back(std::move(tickets));
+            }
+        }
+        for (idx_t i = 0; i < shared.coalesced.size(); i++) {
+            const auto& call = shared.coalesced[i];
+            if (call.prefilter) {
+                auto model = call.model;
+                candidates[i] = EmbeddingPrefilter::Apply(context.client, tuples_json[call.tuples].tuples,
+                                                          call.user_prompt, call.function_type,
+                                                          call.columns[0].threshold, model);
+            }
+        }
+    } catch (std::exception& ex) {
+        shared.SetError(ex);
+        duckdb::vector<duckdb::InterruptState> to_wake;
+        {
+            std::lock_guard<std::mutex> guard(shared.lock);
+            shared.FinishWork(*projected, 1, to_wake);
+        }
+        shared.Release(to_wake);
+        throw;
+    }
+
+    auto rows = projected->input->size();
+    auto evaluate_chunk = !shared.llm_expressions.empty();
+    duckdb::vector<duckdb::InterruptState> to_wake;
+    {
+        std::lock_guard<std::mutex> guard(shared.lock);
+        projected->outstanding += rows * shared.coalesced.size() + (evaluate_chunk ? 1 : 0);
+        for (idx_t i = 0; i < shared.coalesced.size(); i++) {
+            const auto tuple_index = shared.coalesced[i].tuples;
+            // The last call reading the tuples takes them, the ones before it get copies
+            const auto is_last_reader =
+                i + 1 == shared.coalesced.size() || shared.coalesced[i + 1].tuples != tuple_index;
+            auto& call_tuples = tuples_json[tuple_index].tuples;
+            auto& call_tickets = tuples_tickets[tuple_index];
+            for (idx_t t = 0; t < call_tuples.size(); t++) {
+                if (!candidates[i].empty() && !candidates[i][t]) {
+                    const auto& column = shared.coalesced[i].columns[0];
+                    for (const auto ticket : call_tickets[t]) {
+                        column.Write(false, std::string(), projected->output->data[column.column],
+                                     ticket % STANDARD_VECTOR_SIZE);
+                        shared.FinishWork(*projected, 1, to_wake);
+                    }
+                    continue;
+                }
+                BatchCoalescer::Batch batch;
+                auto added = is_last_reader
+                                 ? shared.coalesced[i].coalescer->Add(std::move(call_tuples[t]),
+                                                                      std::move(call_tickets[t]), batch)
+                                 : shared.coalesced[i].coalescer->Add(call_tuples[t], call_tickets[t], batch);
+                if (added) {
+                    batches.push_back({i, std::move(batch)});
+                    shared.running++;
+                }
+            }
+        }
+        if (evaluate_chunk) {
+            shared.running++;
+        }
+        shared.FinishWork(*projected, 1, to_wake);
+    }
+    shared.Release(to_wake);
+
+    auto shared_ptr = gstate.shared;
+    auto& client = context.client;
+    if (evaluate_chunk) {
+        IoReactor::Get().Submit(
+            [shared_ptr, &client, projected]() { EvaluateChunk(*shared_ptr, client, *projected); });
+    }
+    SubmitBatches(shared_ptr, client, batches);
+    return duckdb::SinkResultType::NEED_MORE_INPUT;
+}
+
+duckdb::SinkFinalizeType PhysicalLlmProjection::Finalize(duckdb::Pipeline& pipeline, duckdb::Event& event,
+                                                         duckdb::ClientContext& context,
+                                                         duckdb::OperatorSinkFinalizeInput& input) const {
+    auto& gstate = input.global_state.Cast<LlmProjectionGlobalSinkState>();
+    auto& shared = *gstate.shared;
+
+    // Responses may still be outstanding, only send the last partial batches and fix the emission order here
+    std::vector<PendingBatch> batches;
+    {
+        std::lock_guard<std::mutex> guard(shared.lock);
+        shared.FlushAll(batches);
+        std::sort(shared.chunks.begin(), shared.chunks.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs->batch_index != rhs->batch_index ? lhs->batch_index < rhs->batch_index
+                                                        : lhs->sequence < rhs->sequence;
+        });
+    }
+    SubmitBatches(gstate.shared, context, batches);
+    return duckdb::SinkFinalizeType::READY;
+}
+
+duckdb::unique_ptr<duckdb::GlobalSourceState>
+PhysicalLlmProjection::GetGlobalSourceState(duckdb::ClientContext& context) const {
+    return duckdb::make_uniq<LlmProjectionSourceState>();
+}
+
+duckdb::SourceResultType PhysicalLlmProjection::GetData(duckdb::ExecutionContext& context, duckdb::DataChunk& chunk,
+                                                        duckdb::OperatorSourceInput& input) const {
+    auto& shared = *sink_state->Cast<LlmProjectionGlobalSinkState>().shared;
+    auto& state = input.global_state.Cast<LlmProjectionSourceState>();
+
+    std::lock_guard<std::mutex> guard(shared.lock);
+    if (shared.error.HasError()) {
+        shared.error.Throw();
+    }
+    if (state.next_chunk >= shared.chunks.size()) {
+        return duckdb::SourceResultType::FINISHED;
+    }
+    auto& projected = *shared.chunks[state.next_chunk];
+    if (!projected.ready) {
+        shared.blocked_tasks.push_back(input.interrupt_state);
+        return duckdb::SourceResultType::BLOCKED;
+    }
+
+    chunk.Reference(*projected.output);
+    projected.output.reset();
+    projected.input.reset();
+    state.next_chunk++;
+    return state.next_chunk < shared.chunks.size() ? duckdb::SourceResultType::HAVE_MORE_OUTPUT
+                                                   : duckdb::SourceResultType::FINISHED;
+}
+
+} // namespace flockmtl
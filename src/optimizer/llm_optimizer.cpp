@@ -0,0 +1,469 @@
+#include "flockmtl/optimizer/llm_optimizer.hpp"
+#include "flockmtl/functions/batch_response_builder.hpp"
+#include "flockmtl/operators/llm_filter.hpp"
+#include "flockmtl/operators/llm_join.hpp"
+#include "flockmtl/operators/llm_projection.hpp"
+
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/optimizer/column_binding_replacer.hpp"
+#include "duckdb/optimizer/optimizer.hpp"
+#include "duckdb/planner/binder.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/expression/bound_constant_expression.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "duckdb/planner/expression_iterator.hpp"
+#include "duckdb/planner/logical_operator_visitor.hpp"
+#include "duckdb/planner/operator/logical_any_join.hpp"
+#include "duckdb/planner/operator/logical_comparison_join.hpp"
+#include "duckdb/planner/operator/logical_filter.hpp"
+#include "duckdb/planner/operator/logical_limit.hpp"
+#include "duckdb/planner/operator/logical_projection.hpp"
+
+#include <algorithm>
+
+namespace flockmtl {
+
+namespace {
+
+// Points the column references of an expression moved above its projection at pass-through columns appended to the
+// projection, adding one per distinct input.
+void RebindInputs(duckdb::unique_ptr<duckdb::Expression>& expression, duckdb::LogicalProjection& projection,
+                  duckdb::column_binding_map_t<idx_t>& inputs) {
+    if (expression->GetExpressionClass() != duckdb::ExpressionClass::BOUND_COLUMN_REF) {
+        duckdb::ExpressionIterator::EnumerateChildren(*expression, [&](duckdb::unique_ptr<duckdb::Expression>& child) {
+            RebindInputs(child, projection, inputs);
+        });
+        return;
+    }
+    const auto& column_ref = expression->Cast<duckdb::BoundColumnRefExpression>();
+    auto entry = inputs.find(column_ref.binding);
+    if (entry == inputs.end()) {
+        entry = inputs.emplace(column_ref.binding, projection.expressions.size()).first;
+        projection.expressions.push_back(column_ref.Copy());
+    }
+    expression = duckdb::make_uniq<duckdb::BoundColumnRefExpression>(
+        column_ref.alias, column_ref.return_type, duckdb::ColumnBinding(projection.table_index, entry->second));
+}
+
+// Whether an expression reads any column of `bindings` and any column outside of them
+void FindSides(const duckdb::Expression& expression, const duckdb::column_binding_set_t& bindings, bool& inside,
+               bool& outside) {
+    if (expression.GetExpressionClass() == duckdb::ExpressionClass::BOUND_COLUMN_REF) {
+        const auto& binding = expression.Cast<duckdb::BoundColumnRefExpression>().binding;
+        (bindings.find(binding) != bindings.end() ? inside : outside) = true;
+        return;
+    }
+    duckdb::ExpressionIterator::EnumerateChildren(
+        expression, [&](const duckdb::Expression& child) { FindSides(child, bindings, inside, outside); });
+}
+
+} // namespace
+
+bool LlmOptimizer::IsLlmFunction(const duckdb::Expression& expression) {
+    if (expression.GetExpressionClass() != duckdb::ExpressionClass::BOUND_FUNCTION) {
+        return false;
+    }
+    const auto& name = expression.Cast<duckdb::BoundFunctionExpression>().function.name;
+    return name == "llm_complete" || name == "llm_complete_json" || name == "llm_filter" ||
+           name == "llm_filter_score" || name == "llm_embedding";
+}
+
+bool LlmOptimizer::ContainsLlmFunction(const duckdb::Expression& expression) {
+    if (IsLlmFunction(expression)) {
+        return true;
+    }
+    auto contains_llm_function = false;
+    duckdb::ExpressionIterator::EnumerateChildren(expression, [&](const duckdb::Expression& child) {
+        contains_llm_function = contains_llm_function || ContainsLlmFunction(child);
+    });
+    return contains_llm_function;
+}
+
+bool LlmOptimizer::IsIncrementalLlmFilter(const duckdb::Expression& expression) {
+    if (!IsLlmFunction(expression)) {
+        return false;
+    }
+    const auto& function = expression.Cast<duckdb::BoundFunctionExpression>();
+    if (function.function.name != "llm_filter" || function.children.size() < 3) {
+        return false;
+    }
+    if (!function.children[0]->IsFoldable() || !function.children[1]->IsFoldable() ||
+        ContainsLlmFunction(*function.children[2])) {
+        return false;
+    }
+    return function.children.size() == 3 || function.children[3]->IsFoldable();
+}
+
+void LlmOptimizer::Optimize(duckdb::OptimizerExtensionInput& input, duckdb::unique_ptr<duckdb::LogicalOperator>& plan) {
+    OrderLlmPredicates(input.context, plan);
+    RewriteLlmJoins(input.context, plan);
+    DeferLlmProjections(plan, plan, input.optimizer.binder);
+    RewriteLimitFilters(input.context, plan);
+    duckdb::Value async_operator;
+    if (input.context.TryGetCurrentSetting("flockmtl_async_llm_operator", async_operator) &&
+        !async_operator.GetValue<bool>()) {
+        return;
+    }
+    RewriteProjections(plan, false);
+}
+
+void LlmOptimizer::FuseLlmPredicates(duckdb::ClientContext& context,
+                                     duckdb::vector<duckdb::unique_ptr<duckdb::Expression>>& predicates) {
+    auto is_fusable = [](const duckdb::Expression& expression) {
+        return IsIncrementalLlmFilter(expression) &&
+               expression.Cast<duckdb::BoundFunctionExpression>().children.size() == 3;
+    };
+    for (idx_t i = 0; i < predicates.size(); i++) {
+        if (!predicates[i] || !is_fusable(*predicates[i])) {
+            continue;
+        }
+        auto& function = predicates[i]->Cast<duckdb::BoundFunctionExpression>();
+        duckdb::vector<idx_t> fused = {i};
+        for (idx_t j = i + 1; j < predicates.size(); j++) {
+            if (predicates[j] && is_fusable(*predicates[j])) {
+                const auto& other = predicates[j]->Cast<duckdb::BoundFunctionExpression>();
+                if (function.children[0]->Equals(*other.children[0]) &&
+                    function.children[2]->Equals(*other.children[2])) {
+                    fused.push_back(j);
+                }
+            }
+        }
+        if (fused.size() == 1) {
+            continue;
+        }
+
+        // One prompt asking for all the conditions at once, the tuples are sent once instead of once per conjunct
+        std::string prompt = FUSED_PROMPT::CONJUNCTION;
+        for (const auto index : fused) {
+            const auto& call = predicates[index]->Cast<duckdb::BoundFunctionExpression>();
+            duckdb::Vector prompt_vector(duckdb::ExpressionExecutor::EvaluateScalar(context, *call.children[1]));
+            auto prompt_details = PromptManager::CreatePromptDetails(CastVectorOfStructsToJson(prompt_vector, 1)[0]);
+            prompt += "\n- " + prompt_details.prompt;
+        }
+        function.children[1] = duckdb::make_uniq<duckdb::BoundConstantExpression>(
+            duckdb::Value::STRUCT({{"prompt", duckdb::Value(prompt)}}));
+        for (idx_t k = 1; k < fused.size(); k++) {
+            predicates[fused[k]].reset();
+        }
+    }
+    predicates.erase(std::remove(predicates.begin(), predicates.end(), nullptr), predicates.end());
+}
+
+void LlmOptimizer::OrderLlmPredicates(duckdb::ClientContext& context,
+                                      duckdb::unique_ptr<duckdb::LogicalOperator>& op) {
+    for (auto& child : op->children) {
+        OrderLlmPredicates(context, child);
+    }
+    if (op->type != duckdb::LogicalOperatorType::LOGICAL_FILTER) {
+        return;
+    }
+    // The adaptive conjunction order only learns an LLM call is slow after paying for it, a separate filter on top
+    // guarantees the cheap conjuncts run first whatever their measured cost
+    auto& filter = op->Cast<duckdb::LogicalFilter>();
+    duckdb::LogicalFilter::SplitPredicates(filter.expressions);
+    duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> cheap_predicates;
+    duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> llm_predicates;
+    for (auto& expression : filter.expressions) {
+        if (ContainsLlmFunction(*expression)) {
+            llm_predicates.push_back(std::move(expression));
+        } else {
+            cheap_predicates.push_back(std::move(expression));
+        }
+    }
+    FuseLlmPredicates(context, llm_predicates);
+    if (cheap_predicates.empty() || llm_predicates.empty()) {
+        filter.expressions = std::move(cheap_predicates.empty() ? llm_predicates : cheap_predicates);
+        return;
+    }
+
+    auto llm_filter = duckdb::make_uniq<duckdb::LogicalFilter>();
+    llm_filter->expressions = std::move(llm_predicates);
+    // The projection map applies to the output of the pair, the LLM conjuncts may need the columns it drops
+    llm_filter->projection_map = std::move(filter.projection_map);
+    filter.projection_map.clear();
+    filter.expressions = std::move(cheap_predicates);
+    if (filter.has_estimated_cardinality) {
+        llm_filter->SetEstimatedCardinality(filter.estimated_cardinality);
+    }
+    llm_filter->children.push_back(std::move(op));
+    op = std::move(llm_filter);
+}
+
+bool LlmOptimizer::CanDeferPast(const duckdb::LogicalOperator& op, const idx_t child_index) {
+    const auto& child = *op.children[child_index];
+    if (op.has_estimated_cardinality && child.has_estimated_cardinality &&
+        op.estimated_cardinality > child.estimated_cardinality) {
+        // A join producing more rows than it consumes would multiply the model calls
+        return false;
+    }
+    switch (op.type) {
+    case duckdb::LogicalOperatorType::LOGICAL_FILTER:
+        return op.Cast<duckdb::LogicalFilter>().projection_map.empty();
+    case duckdb::LogicalOperatorType::LOGICAL_COMPARISON_JOIN: {
+        const auto& join = op.Cast<duckdb::LogicalComparisonJoin>();
+        if (!join.left_projection_map.empty() || !join.right_projection_map.empty()) {
+            return false;
+        }
+        // Outer joins would call the model on the NULLs they produce, semi and anti joins only output their left side
+        switch (join.join_type) {
+        case duckdb::JoinType::INNER:
+            return true;
+        case duckdb::JoinType::SEMI:
+        case duckdb::JoinType::ANTI:
+            return child_index == 0;
+        default:
+            return false;
+        }
+    }
+    default:
+        return false;
+    }
+}
+
+void LlmOptimizer::DeferLlmProjections(duckdb::unique_ptr<duckdb::LogicalOperator>& op,
+                                       duckdb::unique_ptr<duckdb::LogicalOperator>& plan, duckdb::Binder& binder) {
+    for (auto& child : op->children) {
+        DeferLlmProjections(child, plan, binder);
+    }
+
+    for (idx_t child_index = 0; child_index < op->children.size(); child_index++) {
+        if (op->children[child_index]->type != duckdb::LogicalOperatorType::LOGICAL_PROJECTION ||
+            !CanDeferPast(*op, child_index)) {
+            continue;
+        }
+        auto& projection = op->children[child_index]->Cast<duckdb::LogicalProjection>();
+        duckdb::vector<bool> deferred(projection.expressions.size(), false);
+        auto has_llm_function = false;
+        for (idx_t i = 0; i < projection.expressions.size(); i++) {
+            deferred[i] = ContainsLlmFunction(*projection.expressions[i]);
+            has_llm_function = has_llm_function || deferred[i];
+        }
+        if (!has_llm_function) {
+            continue;
+        }
+        auto referenced = false;
+        duckdb::LogicalOperatorVisitor::EnumerateExpressions(
+            *op, [&](duckdb::unique_ptr<duckdb::Expression>* expression) {
+                duckdb::ExpressionIterator::EnumerateExpression(*expression, [&](duckdb::Expression& child) {
+                    if (child.GetExpressionClass() != duckdb::ExpressionClass::BOUND_COLUMN_REF) {
+                        return;
+                    }
+                    const auto& binding = child.Cast<duckdb::BoundColumnRefExpression>().binding;
+                    referenced = referenced || (binding.table_index == projection.table_index &&
+                                                deferred[binding.column_index]);
+                });
+            });
+        if (referenced) {
+            continue;
+        }
+
+        // The output of `op` as the operators above know it
+        op->ResolveOperatorTypes();
+        const auto bindings = op->GetColumnBindings();
+        const auto types = op->types;
+
+        // The projection keeps its column positions, the deferred columns become NULL placeholders nothing reads
+        duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> deferred_expressions(projection.expressions.size());
+        duckdb::column_binding_map_t<idx_t> inputs;
+        for (idx_t i = 0; i < projection.expressions.size(); i++) {
+            if (!deferred[i]) {
+                continue;
+            }
+            auto type = projection.expressions[i]->return_type;
+            deferred_expressions[i] = std::move(projection.expressions[i]);
+            projection.expressions[i] = duckdb::make_uniq<duckdb::BoundConstantExpression>(duckdb::Value(type));
+            RebindInputs(deferred_expressions[i], projection, inputs);
+        }
+
+        auto table_index = binder.GenerateTableIndex();
+        duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> select_list;
+        duckdb::ColumnBindingReplacer replacer;
+        for (idx_t i = 0; i < bindings.size(); i++) {
+            if (bindings[i].table_index == projection.table_index && deferred[bindings[i].column_index]) {
+                select_list.push_back(std::move(deferred_expressions[bindings[i].column_index]));
+            } else {
+                select_list.push_back(duckdb::make_uniq<duckdb::BoundColumnRefExpression>(types[i], bindings[i]));
+            }
+            replacer.replacement_bindings.emplace_back(bindings[i], duckdb::ColumnBinding(table_index, i));
+        }
+
+        auto late_projection = duckdb::make_uniq<duckdb::LogicalProjection>(table_index, std::move(select_list));
+        if (op->has_estimated_cardinality) {
+            late_projection->SetEstimatedCardinality(op->estimated_cardinality);
+        }
+        replacer.stop_operator = late_projection.get();
+        late_projection->children.push_back(std::move(op));
+        op = std::move(late_projection);
+        replacer.VisitOperator(*plan);
+        return;
+    }
+}
+
+void LlmOptimizer::RewriteLlmJoins(duckdb::ClientContext& context, duckdb::unique_ptr<duckdb::LogicalOperator>& op) {
+    for (auto& child : op->children) {
+        RewriteLlmJoins(context, child);
+    }
+    if (op->type != duckdb::LogicalOperatorType::LOGICAL_ANY_JOIN) {
+        return;
+    }
+    auto& join = op->Cast<duckdb::LogicalAnyJoin>();
+    if (join.join_type != duckdb::JoinType::INNER || !join.left_projection_map.empty() ||
+        !join.right_projection_map.empty() || !IsIncrementalLlmFilter(*join.condition)) {
+        return;
+    }
+    auto& filter = join.condition->Cast<duckdb::BoundFunctionExpression>();
+    if (filter.children.size() != 3 ||
+        filter.children[2]->GetExpressionClass() != duckdb::ExpressionClass::BOUND_FUNCTION ||
+        filter.children[2]->Cast<duckdb::BoundFunctionExpression>().function.name != "struct_pack") {
+        return;
+    }
+    duckdb::Value embedding_model;
+    if (!context.TryGetCurrentSetting("flockmtl_join_embedding_model", embedding_model) || embedding_model.IsNull() ||
+        embedding_model.ToString().empty()) {
+        return;
+    }
+    auto top_k = static_cast<idx_t>(Config::default_join_top_k);
+    duckdb::Value top_k_value;
+    if (context.TryGetCurrentSetting("flockmtl_join_top_k", top_k_value) && !top_k_value.IsNull()) {
+        top_k = static_cast<idx_t>(std::max<int64_t>(top_k_value.GetValue<int64_t>(), 1));
+    }
+
+    // Every field of the input struct has to come from a single side, each side embedding its own fields
+    auto& inputs = filter.children[2]->Cast<duckdb::BoundFunctionExpression>();
+    duckdb::column_binding_set_t left_bindings;
+    for (const auto& binding : join.children[0]->GetColumnBindings()) {
+        left_bindings.insert(binding);
+    }
+    duckdb::vector<bool> from_left;
+    for (const auto& field : inputs.children) {
+        auto uses_left = false;
+        auto uses_right = false;
+        FindSides(*field, left_bindings, uses_left, uses_right);
+        if (uses_left && uses_right) {
+            return;
+        }
+        from_left.push_back(!uses_right);
+    }
+    if (std::find(from_left.begin(), from_left.end(), true) == from_left.end() ||
+        std::find(from_left.begin(), from_left.end(), false) == from_left.end()) {
+        return;
+    }
+
+    duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> expressions;
+    expressions.push_back(std::move(filter.children[0]));
+    expressions.push_back(std::move(filter.children[1]));
+    auto llm_join = duckdb::make_uniq<LogicalLlmJoin>(std::move(expressions), embedding_model.ToString(), top_k);
+    const auto& fields = duckdb::StructType::GetChildTypes(inputs.return_type);
+    for (idx_t i = 0; i < inputs.children.size(); i++) {
+        if (from_left[i]) {
+            llm_join->left_inputs.push_back(std::move(inputs.children[i]));
+            llm_join->left_names.push_back(fields[i].first);
+        } else {
+            llm_join->right_inputs.push_back(std::move(inputs.children[i]));
+            llm_join->right_names.push_back(fields[i].first);
+        }
+    }
+    llm_join->children = std::move(join.children);
+    llm_join->estimated_cardinality = join.estimated_cardinality;
+    llm_join->has_estimated_cardinality = join.has_estimated_cardinality;
+    op = std::move(llm_join);
+}
+
+void LlmOptimizer::RewriteLimitFilters(duckdb::ClientContext& context,
+                                       duckdb::unique_ptr<duckdb::LogicalOperator>& op) {
+    for (auto& child : op->children) {
+        RewriteLimitFilters(context, child);
+    }
+    if (op->type != duckdb::LogicalOperatorType::LOGICAL_LIMIT) {
+        return;
+    }
+    auto& limit = op->Cast<duckdb::LogicalLimit>();
+    if (limit.limit_val.Type() != duckdb::LimitNodeType::CONSTANT_VALUE) {
+        return;
+    }
+    auto needed = limit.limit_val.GetConstantValue();
+    if (limit.offset_val.Type() == duckdb::LimitNodeType::CONSTANT_VALUE) {
+        needed += limit.offset_val.GetConstantValue();
+    } else if (limit.offset_val.Type() != duckdb::LimitNodeType::UNSET) {
+        return;
+    }
+    // The first rows to pass on any thread are not the first rows of the input, a LIMIT over an ordered scan would
+    // get the wrong ones
+    if (needed > 0 && duckdb::DBConfig::GetConfig(context).options.preserve_insertion_order) {
+        return;
+    }
+
+    // Projections keep the row count, so the filter below them still only has to produce `needed` rows
+    auto* target = &op->children[0];
+    while ((*target)->type == duckdb::LogicalOperatorType::LOGICAL_PROJECTION) {
+        target = &(*target)->children[0];
+    }
+    if ((*target)->type != duckdb::LogicalOperatorType::LOGICAL_FILTER) {
+        return;
+    }
+    auto& filter = (*target)->Cast<duckdb::LogicalFilter>();
+    if (!filter.projection_map.empty()) {
+        return;
+    }
+    duckdb::LogicalFilter::SplitPredicates(filter.expressions);
+    idx_t llm_filters = 0;
+    for (const auto& expression : filter.expressions) {
+        if (IsIncrementalLlmFilter(*expression)) {
+            llm_filters++;
+        } else if (ContainsLlmFunction(*expression)) {
+            return;
+        }
+    }
+    if (llm_filters != 1) {
+        return;
+    }
+
+    auto llm_filter = duckdb::make_uniq<LogicalLlmFilter>(std::move(filter.expressions), needed);
+    llm_filter->children = std::move(filter.children);
+    if (filter.has_estimated_cardinality) {
+        llm_filter->SetEstimatedCardinality(filter.estimated_cardinality);
+    }
+    *target = std::move(llm_filter);
+}
+
+void LlmOptimizer::RewriteProjections(duckdb::unique_ptr<duckdb::LogicalOperator>& op, const bool under_limit) {
+    // A projection streaming into a LIMIT must stay streaming, the async operator consumes its whole input
+    auto child_under_limit = under_limit;
+    switch (op->type) {
+    case duckdb::LogicalOperatorType::LOGICAL_LIMIT:
+        child_under_limit = true;
+        break;
+    case duckdb::LogicalOperatorType::LOGICAL_ORDER_BY:
+    case duckdb::LogicalOperatorType::LOGICAL_AGGREGATE_AND_GROUP_BY:
+        child_under_limit = false;
+        break;
+    default:
+        break;
+    }
+    for (auto& child : op->children) {
+        RewriteProjections(child, child_under_limit);
+    }
+
+    if (op->type != duckdb::LogicalOperatorType::LOGICAL_PROJECTION || under_limit) {
+        return;
+    }
+    auto& projection = op->Cast<duckdb::LogicalProjection>();
+    auto has_llm_function = false;
+    for (const auto& expression : projection.expressions) {
+        has_llm_function = has_llm_function || ContainsLlmFunction(*expression);
+    }
+    if (!has_llm_function) {
+        return;
+    }
+
+    auto llm_projection =
+        duckdb::make_uniq<LogicalLlmProjection>(projection.table_index, std::move(projection.expressions));
+    llm_projection->children = std::move(projection.children);
+    if (projection.has_estimated_cardinality) {
+        llm_projection->SetEstimatedCardinality(projection.estimated_cardinality);
+    }
+    op = std::move(llm_projection);
+}
+
+} // namespace flockmtl
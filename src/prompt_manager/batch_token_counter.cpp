@@ -0,0 +1,91 @@
+#include "flockmtl/prompt_manager/batch_token_counter.hpp"
+#include "flockmtl/model_manager/tiktoken.hpp"
+
+#include <algorithm>
+
+namespace flockmtl {
+
+int BatchTokenCounter::CellTokens(const nlohmann::json& value) {
+    return Tiktoken::GetNumTokens(TupleSerializer::ValueToText(value));
+}
+
+bool BatchTokenCounter::IsAliasable(const nlohmann::json& value) {
+    return value.is_string() && value.get_ref<const std::string&>().size() >= TupleSerializer::min_alias_length;
+}
+
+int BatchTokenCounter::Delta(const nlohmann::json& tuple, std::vector<int>& cell_tokens) const {
+    cell_tokens.assign(tuple.size(), -1);
+    if (rows_ == 0) {
+        return Tiktoken::GetNumTokens(TupleSerializer::SerializeHeader(tuple, format_)) +
+               Tiktoken::GetNumTokens(TupleSerializer::SerializeTuple(tuple, format_));
+    }
+
+    int delta = Tiktoken::GetNumTokens(TupleSerializer::SerializeTuple(tuple, format_));
+    size_t index = 0;
+    for (const auto& cell : tuple.items()) {
+        auto& tokens = cell_tokens[index++];
+        const auto column = columns_.find(cell.key());
+        if (column != columns_.end() && column->second.constant) {
+            if (cell.value() == column->second.value) {
+                tokens = CellTokens(cell.value());
+                delta -= tokens;
+            } else {
+                // The column is no longer hoisted, its cells are written in every row again
+                delta += static_cast<int>(column->second.hoisted_tokens);
+            }
+            continue;
+        }
+        if (!IsAliasable(cell.value())) {
+            continue;
+        }
+        const auto seen = occurrences_.find(cell.value().get<std::string>());
+        const auto count = seen == occurrences_.end() ? 0 : seen->second;
+        tokens = CellTokens(cell.value());
+        if (count == 1) {
+            // Second occurrence: both cells become aliases and the text moves into a definition
+            delta += 2 * alias_tokens + alias_definition_tokens - tokens;
+        } else if (count > 1) {
+            delta -= tokens - alias_tokens;
+        }
+    }
+    return delta;
+}
+
+BatchTokenCounter::Measurement BatchTokenCounter::Measure(const nlohmann::json& tuple) const {
+    Measurement measurement;
+    measurement.tokens = tokens_ + static_cast<unsigned>(std::max(Delta(tuple, measurement.cell_tokens), 0));
+    return measurement;
+}
+
+void BatchTokenCounter::Add(const nlohmann::json& tuple, const Measurement& measurement) {
+    tokens_ = measurement.tokens;
+    size_t index = 0;
+    for (const auto& cell : tuple.items()) {
+        const auto tokens = index < measurement.cell_tokens.size() ? measurement.cell_tokens[index] : -1;
+        index++;
+        auto column = columns_.find(cell.key());
+        if (column == columns_.end()) {
+            columns_.emplace(cell.key(), ColumnState {cell.value(), rows_ == 0, 0});
+        } else if (column->second.constant) {
+            if (cell.value() == column->second.value) {
+                column->second.hoisted_tokens += tokens >= 0 ? tokens : CellTokens(cell.value());
+            } else {
+                column->second.constant = false;
+                column->second.hoisted_tokens = 0;
+            }
+        }
+        if (IsAliasable(cell.value())) {
+            occurrences_[cell.value().get<std::string>()]++;
+        }
+    }
+    rows_++;
+}
+
+void BatchTokenCounter::Clear() {
+    rows_ = 0;
+    tokens_ = 0;
+    columns_.clear();
+    occurrences_.clear();
+}
+
+} // namespace flockmtl
@@ -0,0 +1,62 @@
+#include "flockmtl/prompt_manager/compiled_template.hpp"
+#include "flockmtl/prompt_manager/prompt_manager.hpp"
+#include "flockmtl/model_manager/tiktoken.hpp"
+
+namespace flockmtl {
+
+CompiledTemplate::CompiledTemplate(const std::string& prompt_template) {
+    const PromptSection sections[] = {PromptSection::USER_PROMPT, PromptSection::TUPLES, PromptSection::INSTRUCTIONS,
+                                      PromptSection::RESPONSE_FORMAT};
+    std::string literal;
+    size_t position = 0;
+    while (position < prompt_template.size()) {
+        auto matched = false;
+        if (prompt_template.compare(position, 2, "{{") == 0) {
+            for (const auto section : sections) {
+                const auto placeholder = PromptManager::ToString(section);
+                if (prompt_template.compare(position, placeholder.size(), placeholder) == 0) {
+                    segments_.push_back({std::move(literal), false, section});
+                    segments_.push_back({"", true, section});
+                    literal.clear();
+                    position += placeholder.size();
+                    matched = true;
+                    break;
+                }
+            }
+        }
+        if (!matched) {
+            literal += prompt_template[position++];
+        }
+    }
+    segments_.push_back({std::move(literal), false, PromptSection::USER_PROMPT});
+
+    for (const auto& segment : segments_) {
+        if (!segment.is_section) {
+            static_size_ += segment.text.size();
+            static_tokens_ += Tiktoken::GetNumTokens(segment.text);
+        }
+    }
+}
+
+void CompiledTemplate::RenderInto(std::string& buffer, const std::string& user_prompt,
+                                  const std::string& tuples) const {
+    buffer.clear();
+    buffer.reserve(static_size_ + user_prompt.size() + tuples.size());
+    for (const auto& segment : segments_) {
+        if (!segment.is_section) {
+            buffer += segment.text;
+        } else if (segment.section == PromptSection::USER_PROMPT) {
+            buffer += user_prompt;
+        } else if (segment.section == PromptSection::TUPLES) {
+            buffer += tuples;
+        }
+    }
+}
+
+std::string CompiledTemplate::Render(const std::string& user_prompt, const std::string& tuples) const {
+    std::string buffer;
+    RenderInto(buffer, user_prompt, tuples);
+    return buffer;
+}
+
+} // namespace flockmtl
@@ -18,6 +18,11 @@ std::string PromptManager::ToString<PromptSection>(PromptSection section) {
     }
 }
 
+const CompiledTemplate& PromptManager::GetTuplesTemplate() {
+    static const CompiledTemplate tuples_template(TUPLES_PROMPT);
+    return tuples_template;
+}
+
 std::string PromptManager::ReplaceSection(const std::string& prompt_template, const PromptSection section,
                                           const std::string& section_content) {
     auto replace_string = PromptManager::ToString(section);
@@ -39,36 +44,44 @@ std::string PromptManager::ReplaceSection(const std::string& prompt_template, co
 }
 
 std::string PromptManager::ConstructMarkdownHeader(const nlohmann::json& tuple) {
-    std::string header_markdown = "|";
-    for (const auto& key : tuple.items()) {
-        header_markdown += key.key() + " | ";
-    }
-    header_markdown += "\n";
-    for (auto i = 0; i < static_cast<int>(tuple.size()); i++) {
-        header_markdown += "|---";
-    }
-    header_markdown += "|\n";
-    return header_markdown;
+    return TupleSerializer::SerializeHeader(tuple, TupleFormat::MARKDOWN);
 }
 
 std::string PromptManager::ConstructMarkdownSingleTuple(const nlohmann::json& tuple) {
-    std::string tuple_markdown = "|";
-    for (const auto& key : tuple.items()) {
-        tuple_markdown += key.value().dump() + " | ";
-    }
-    tuple_markdown += "\n";
-    return tuple_markdown;
+    return TupleSerializer::SerializeTuple(tuple, TupleFormat::MARKDOWN);
 }
 
 std::string PromptManager::ConstructMarkdownArrayTuples(const nlohmann::json& tuples) {
-    std::string tuples_markdown = "";
-    tuples_markdown += PromptManager::ConstructMarkdownHeader(tuples[0]);
-    for (const auto& tuple : tuples) {
-        tuples_markdown += PromptManager::ConstructMarkdownSingleTuple(tuple);
+    return TupleSerializer::Serialize(tuples, TupleFormat::MARKDOWN);
+}
+
+std::string PromptManager::FusePrompts(const std::vector<std::pair<std::string, ScalarFunctionType>>& tasks) {
+    std::string prompt = FUSED_PROMPT::HEADER;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        std::string answer;
+        switch (tasks[i].second) {
+        case ScalarFunctionType::COMPLETE_JSON:
+            answer = FUSED_PROMPT::COMPLETE_JSON;
+            break;
+        case ScalarFunctionType::FILTER:
+        case ScalarFunctionType::FILTER_IDS:
+        case ScalarFunctionType::FILTER_PROBABILITY:
+            answer = FUSED_PROMPT::FILTER;
+            break;
+        case ScalarFunctionType::FILTER_SCORE:
+            answer = FUSED_PROMPT::FILTER_SCORE;
+            break;
+        default:
+            answer = FUSED_PROMPT::COMPLETE;
+            break;
+        }
+        prompt += fmt::format("\n\n- \"{}\" (answer with {}): {}", FusedTaskKey(i), answer, tasks[i].first);
     }
-    return tuples_markdown;
+    return prompt;
 }
 
+std::string PromptManager::FusedTaskKey(const size_t index) { return fmt::format("task_{}", index + 1); }
+
 PromptDetails PromptManager::CreatePromptDetails(const nlohmann::json& prompt_details_json) {
     PromptDetails prompt_details;
 
@@ -85,7 +98,8 @@ PromptDetails PromptManager::CreatePromptDetails(const nlohmann::json& prompt_de
         std::string version_where_clause;
         std::string order_by_clause;
         if (prompt_details_json.contains("version")) {
-            prompt_details.version = std::stoi(prompt_details_json["version"].get<std::string>());
+            const auto& version = prompt_details_json["version"];
+            prompt_details.version = version.is_string() ? std::stoi(version.get<std::string>()) : version.get<int>();
             version_where_clause = duckdb_fmt::format(" AND version = {}", prompt_details.version);
             error_message = duckdb_fmt::format("with version {} not found", prompt_details.version);
         } else {
@@ -20,8 +20,15 @@ std::string RESPONSE_FORMAT::Get(const ScalarFunctionType option) {
         return RESPONSE_FORMAT::COMPLETE_JSON;
     case ScalarFunctionType::COMPLETE:
         return RESPONSE_FORMAT::COMPLETE;
+    case ScalarFunctionType::COMPLETE_SCORED:
+        return RESPONSE_FORMAT::COMPLETE_SCORED;
     case ScalarFunctionType::FILTER:
+    case ScalarFunctionType::FILTER_PROBABILITY:
         return RESPONSE_FORMAT::FILTER;
+    case ScalarFunctionType::FILTER_IDS:
+        return RESPONSE_FORMAT::FILTER_IDS;
+    case ScalarFunctionType::FILTER_SCORE:
+        return RESPONSE_FORMAT::FILTER_SCORE;
     default:
         return "";
     }
@@ -0,0 +1,297 @@
+#include "flockmtl/prompt_manager/tuple_serializer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace flockmtl {
+
+TupleFormat TupleSerializer::ParseFormat(const std::string& format) {
+    if (format == "markdown") {
+        return TupleFormat::MARKDOWN;
+    }
+    if (format == "compact_markdown") {
+        return TupleFormat::COMPACT_MARKDOWN;
+    }
+    if (format == "csv") {
+        return TupleFormat::CSV;
+    }
+    if (format == "tsv") {
+        return TupleFormat::TSV;
+    }
+    if (format == "jsonl") {
+        return TupleFormat::JSONL;
+    }
+    if (format == "columnar") {
+        return TupleFormat::COLUMNAR;
+    }
+    throw std::runtime_error("Unsupported tuple_format `" + format +
+                             "`, expected one of markdown, compact_markdown, csv, tsv, jsonl or columnar");
+}
+
+std::string TupleSerializer::FormatName(const TupleFormat format) {
+    switch (format) {
+    case TupleFormat::MARKDOWN:
+        return "markdown";
+    case TupleFormat::COMPACT_MARKDOWN:
+        return "compact_markdown";
+    case TupleFormat::CSV:
+        return "csv";
+    case TupleFormat::TSV:
+        return "tsv";
+    case TupleFormat::JSONL:
+        return "jsonl";
+    case TupleFormat::COLUMNAR:
+        return "columnar";
+    default:
+        return "";
+    }
+}
+
+std::string TupleSerializer::ValueToText(const nlohmann::json& value) {
+    if (value.is_string()) {
+        return value.get<std::string>();
+    }
+    if (value.is_null()) {
+        return "NULL";
+    }
+    return value.dump();
+}
+
+std::string TupleSerializer::Escape(const std::string& text, const TupleFormat format) {
+    switch (format) {
+    case TupleFormat::CSV: {
+        if (text.find_first_of(",\"\n\r") == std::string::npos) {
+            return text;
+        }
+        std::string quoted = "\"";
+        for (const auto c : text) {
+            quoted += c == '"' ? "\"\"" : std::string(1, c);
+        }
+        return quoted + "\"";
+    }
+    case TupleFormat::TSV:
+    case TupleFormat::COMPACT_MARKDOWN:
+    case TupleFormat::COLUMNAR: {
+        // One line per tuple (or column), so separators and line breaks inside values are neutralized
+        const auto separator = format == TupleFormat::TSV ? '\t' : '|';
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (const auto c : text) {
+            if (c == '\n' || c == '\r' || (c == '\t' && format == TupleFormat::TSV)) {
+                escaped += ' ';
+            } else if (c == separator) {
+                escaped += "\\|";
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+    default:
+        return text;
+    }
+}
+
+std::string TupleSerializer::SerializeHeader(const nlohmann::json& tuple, const TupleFormat format) {
+    std::string header;
+    switch (format) {
+    case TupleFormat::MARKDOWN: {
+        header = "|";
+        for (const auto& key : tuple.items()) {
+            header += key.key() + " | ";
+        }
+        header += "\n";
+        for (auto i = 0; i < static_cast<int>(tuple.size()); i++) {
+            header += "|---";
+        }
+        header += "|\n";
+        break;
+    }
+    case TupleFormat::COMPACT_MARKDOWN:
+    case TupleFormat::CSV:
+    case TupleFormat::TSV: {
+        const auto separator = format == TupleFormat::CSV ? "," : format == TupleFormat::TSV ? "\t" : "|";
+        auto first = true;
+        for (const auto& key : tuple.items()) {
+            header += (first ? "" : separator) + Escape(key.key(), format);
+            first = false;
+        }
+        header += "\n";
+        if (format == TupleFormat::COMPACT_MARKDOWN) {
+            for (auto i = 0; i < static_cast<int>(tuple.size()); i++) {
+                header += i == 0 ? "-" : "|-";
+            }
+            header += "\n";
+        }
+        break;
+    }
+    case TupleFormat::COLUMNAR: {
+        for (const auto& key : tuple.items()) {
+            header += key.key() + ": \n";
+        }
+        break;
+    }
+    case TupleFormat::JSONL:
+    default:
+        break;
+    }
+    return header;
+}
+
+std::string TupleSerializer::SerializeTuple(const nlohmann::json& tuple, const TupleFormat format) {
+    std::string row;
+    switch (format) {
+    case TupleFormat::MARKDOWN: {
+        row = "|";
+        for (const auto& key : tuple.items()) {
+            row += key.value().dump() + " | ";
+        }
+        row += "\n";
+        break;
+    }
+    case TupleFormat::JSONL:
+        row = tuple.dump() + "\n";
+        break;
+    case TupleFormat::COMPACT_MARKDOWN:
+    case TupleFormat::CSV:
+    case TupleFormat::TSV:
+    case TupleFormat::COLUMNAR: {
+        const auto separator = format == TupleFormat::CSV ? "," : format == TupleFormat::TSV ? "\t" : "|";
+        auto first = true;
+        for (const auto& key : tuple.items()) {
+            row += (first ? "" : separator) + Escape(ValueToText(key.value()), format);
+            first = false;
+        }
+        row += "\n";
+        break;
+    }
+    default:
+        break;
+    }
+    return row;
+}
+
+std::string TupleSerializer::CompactBatch(const nlohmann::json& tuples, nlohmann::json& compacted) {
+    if (tuples.size() < 2) {
+        return "";
+    }
+
+    std::vector<std::string> hoisted;
+    for (const auto& column : tuples[0].items()) {
+        auto constant = true;
+        for (const auto& tuple : tuples) {
+            const auto value = tuple.find(column.key());
+            if (value == tuple.end() || *value != column.value()) {
+                constant = false;
+                break;
+            }
+        }
+        if (constant) {
+            hoisted.push_back(column.key());
+        }
+    }
+    // Every row still needs something to answer about
+    if (hoisted.size() == tuples[0].size()) {
+        hoisted.clear();
+    }
+    const auto is_hoisted = [&hoisted](const std::string& key) {
+        return std::find(hoisted.begin(), hoisted.end(), key) != hoisted.end();
+    };
+
+    // Aliases start with one more '@' than any value in the rows, so a literal like "@1" is never read as one
+    std::unordered_map<std::string, int> occurrences;
+    size_t alias_prefix_length = 1;
+    for (const auto& tuple : tuples) {
+        for (const auto& cell : tuple.items()) {
+            if (!cell.value().is_string() || is_hoisted(cell.key())) {
+                continue;
+            }
+            const auto& text = cell.value().get_ref<const std::string&>();
+            alias_prefix_length = std::max(alias_prefix_length, std::min(text.find_first_not_of('@'), text.size()) + 1);
+            if (text.size() >= min_alias_length) {
+                occurrences[text]++;
+            }
+        }
+    }
+    const std::string alias_prefix(alias_prefix_length, '@');
+    std::unordered_map<std::string, std::string> aliases;
+    std::vector<std::string> alias_order;
+    for (const auto& tuple : tuples) {
+        for (const auto& cell : tuple.items()) {
+            if (!cell.value().is_string() || is_hoisted(cell.key())) {
+                continue;
+            }
+            const auto& text = cell.value().get_ref<const std::string&>();
+            if (occurrences.count(text) && occurrences[text] > 1 && !aliases.count(text)) {
+                aliases[text] = alias_prefix + std::to_string(alias_order.size() + 1);
+                alias_order.push_back(text);
+            }
+        }
+    }
+    if (hoisted.empty() && aliases.empty()) {
+        return "";
+    }
+
+    std::string preamble;
+    if (!hoisted.empty()) {
+        preamble += "Same value in every tuple:\n";
+        for (const auto& key : hoisted) {
+            preamble += "- " + key + ": " + ValueToText(tuples[0][key]) + "\n";
+        }
+    }
+    if (!aliases.empty()) {
+        preamble += "Aliases used in the tuples:\n";
+        for (const auto& text : alias_order) {
+            preamble += "- " + aliases[text] + ": " + text + "\n";
+        }
+    }
+    preamble += "\n";
+
+    compacted = nlohmann::json::array();
+    for (const auto& tuple : tuples) {
+        nlohmann::json compacted_tuple = nlohmann::json::object();
+        for (const auto& cell : tuple.items()) {
+            if (is_hoisted(cell.key())) {
+                continue;
+            }
+            const auto alias = cell.value().is_string() ? aliases.find(cell.value().get<std::string>()) : aliases.end();
+            compacted_tuple[cell.key()] = alias != aliases.end() ? nlohmann::json(alias->second) : cell.value();
+        }
+        compacted.push_back(std::move(compacted_tuple));
+    }
+    return preamble;
+}
+
+std::string TupleSerializer::Serialize(const nlohmann::json& tuples, const TupleFormat format) {
+    if (tuples.empty()) {
+        return "";
+    }
+    nlohmann::json compacted;
+    auto serialized = CompactBatch(tuples, compacted);
+    const auto& body = serialized.empty() ? tuples : compacted;
+
+    if (format != TupleFormat::COLUMNAR) {
+        serialized += SerializeHeader(body[0], format);
+        for (const auto& tuple : body) {
+            serialized += SerializeTuple(tuple, format);
+        }
+        return serialized;
+    }
+
+    // Each column name once, followed by its values in tuple order
+    for (const auto& column : body[0].items()) {
+        serialized += column.key() + ": ";
+        auto first = true;
+        for (const auto& tuple : body) {
+            const auto value = tuple.find(column.key());
+            serialized += (first ? "" : "|") + Escape(value == tuple.end() ? "NULL" : ValueToText(*value), format);
+            first = false;
+        }
+        serialized += "\n";
+    }
+    return serialized;
+}
+
+} // namespace flockmtl
@@ -6,6 +6,7 @@ void AggregateRegistry::Register(duckdb::DatabaseInstance& db) {
     RegisterLlmFirst(db);
     RegisterLlmLast(db);
     RegisterLlmRerank(db);
+    RegisterLlmCluster(db);
     RegisterLlmReduce(db);
     RegisterLlmReduceJson(db);
 }
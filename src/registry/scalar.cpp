@@ -7,6 +7,7 @@ void ScalarRegistry::Register(duckdb::DatabaseInstance& db) {
     RegisterLlmComplete(db);
     RegisterLlmEmbedding(db);
     RegisterLlmFilter(db);
+    RegisterLlmFilterScore(db);
     RegisterFusionRelative(db);
 }
 
@@ -0,0 +1,11 @@
+#include "flockmtl/registry/table.hpp"
+
+namespace flockmtl {
+
+void TableRegistry::Register(duckdb::DatabaseInstance& db) {
+    RegisterFlockmtlCascadeStats(db);
+    RegisterFlockmtlPrefilterStats(db);
+    RegisterFlockmtlUsage(db);
+}
+
+} // namespace flockmtl
@@ -0,0 +1,74 @@
+#include "catch.hpp"
+#include "flockmtl/functions/aggregate/aggregate_state.hpp"
+
+#include <map>
+
+using flockmtl::AggregateFunctionState;
+
+namespace {
+
+// How often each tuple 0..num_tuples-1 ends up in the sample over many runs, with the tuples split across
+// `num_states` states that are then combined
+std::map<int, int> SampleCounts(const int num_tuples, const int sample_size, const int num_states, const int runs) {
+    std::map<int, int> counts;
+    for (auto run = 0; run < runs; run++) {
+        std::vector<AggregateFunctionState> states(num_states);
+        for (auto& state : states) {
+            state.sample_size = sample_size;
+            state.random.state = run * num_states + (&state - states.data()) + 1;
+        }
+        for (auto i = 0; i < num_tuples; i++) {
+            // Uneven split, the first state receives half of the tuples
+            states[i % 2 == 0 ? 0 : 1 + i % (num_states - 1)].Update(i);
+        }
+        AggregateFunctionState combined;
+        combined.random.state = run + 1;
+        for (const auto& state : states) {
+            combined.Combine(state);
+        }
+        REQUIRE(combined.value.size() == static_cast<size_t>(sample_size));
+        REQUIRE(combined.seen == static_cast<uint64_t>(num_tuples));
+        for (const auto& tuple : combined.value) {
+            counts[tuple.get<int>()]++;
+        }
+    }
+    return counts;
+}
+
+} // namespace
+
+TEST_CASE("Groups without a sample size keep every tuple", "[aggregate_state]") {
+    AggregateFunctionState lhs;
+    AggregateFunctionState rhs;
+    for (auto i = 0; i < 100; i++) {
+        (i < 30 ? lhs : rhs).Update(i);
+    }
+    lhs.Combine(rhs);
+    REQUIRE(lhs.value.size() == 100);
+    REQUIRE(lhs.seen == 100);
+}
+
+TEST_CASE("Update keeps a bounded reservoir", "[aggregate_state]") {
+    AggregateFunctionState state;
+    state.sample_size = 10;
+    for (auto i = 0; i < 1000; i++) {
+        state.Update(i);
+    }
+    REQUIRE(state.value.size() == 10);
+    REQUIRE(state.seen == 1000);
+}
+
+TEST_CASE("Combined reservoirs stay uniform", "[aggregate_state]") {
+    const auto num_tuples = 100;
+    const auto sample_size = 20;
+    const auto runs = 4000;
+    const auto counts = SampleCounts(num_tuples, sample_size, 3, runs);
+
+    // Each tuple is expected runs * sample_size / num_tuples = 800 times, the bounds are about five deviations
+    const auto expected = static_cast<double>(runs) * sample_size / num_tuples;
+    for (auto i = 0; i < num_tuples; i++) {
+        const auto count = counts.count(i) ? counts.at(i) : 0;
+        REQUIRE(count > expected * 0.85);
+        REQUIRE(count < expected * 1.15);
+    }
+}
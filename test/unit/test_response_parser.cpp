@@ -0,0 +1,91 @@
+#include "catch.hpp"
+#include "flockmtl/model_manager/response_parser.hpp"
+
+using flockmtl::ResponseParser;
+
+TEST_CASE("Completions are parsed with or without a code fence", "[response_parser]") {
+    const auto expected = nlohmann::json::parse(R"({"tuples": [{"id": 0, "response": true}]})");
+    REQUIRE(ResponseParser::Parse(R"({"tuples": [{"id": 0, "response": true}]})") == expected);
+    REQUIRE(ResponseParser::Parse("```json\n{\"tuples\": [{\"id\": 0, \"response\": true}]}\n```") == expected);
+    REQUIRE(ResponseParser::Parse("  ```\n{\"tuples\": [{\"id\": 0, \"response\": true}]}\n```\n") == expected);
+}
+
+TEST_CASE("Backticks inside the JSON are kept", "[response_parser]") {
+    REQUIRE(ResponseParser::Parse(R"({"response": "```sql\nSELECT 1\n```"})")["response"] == "```sql\nSELECT 1\n```");
+    REQUIRE(ResponseParser::Parse("```json\n{\"response\": \"use ``` fences\"}\n```")["response"] == "use ``` fences");
+}
+
+TEST_CASE("Truncated completions keep their complete elements", "[response_parser]") {
+    const auto repaired = ResponseParser::Parse(R"({"tuples": [{"id": 0, "response": "a"}, {"id": 1, "respo)");
+    REQUIRE(repaired == nlohmann::json::parse(R"({"tuples": [{"id": 0, "response": "a"}]})"));
+
+    // A fenced completion cut before its closing fence
+    const auto fenced = ResponseParser::Parse("```json\n{\"tuples\": [{\"id\": 0, \"response\": 1}, {\"id\"");
+    REQUIRE(fenced == nlohmann::json::parse(R"({"tuples": [{"id": 0, "response": 1}]})"));
+
+    // Nothing complete yet
+    REQUIRE(ResponseParser::Parse(R"({"tuples": [{"id": 0, "resp)") == nlohmann::json::parse(R"({"tuples": []})"));
+    REQUIRE_THROWS(ResponseParser::Parse("not json"));
+}
+
+TEST_CASE("Tuple ids are integers or digit strings", "[response_parser]") {
+    REQUIRE(ResponseParser::ParseTupleId(3) == 3);
+    REQUIRE(ResponseParser::ParseTupleId("12") == 12);
+    REQUIRE(ResponseParser::ParseTupleId("") == -1);
+    REQUIRE(ResponseParser::ParseTupleId("1a") == -1);
+    REQUIRE(ResponseParser::ParseTupleId(1.5) == -1);
+    REQUIRE(ResponseParser::ParseTupleId(nullptr) == -1);
+}
+
+TEST_CASE("Selected ids become one boolean per tuple", "[response_parser]") {
+    const auto booleans = ResponseParser::IdsToBooleans(nlohmann::json::parse(R"([2, "0", 7, -1, "x", 2])"), 4);
+    REQUIRE(booleans == nlohmann::json::parse("[true, false, true, false]"));
+    REQUIRE(ResponseParser::IdsToBooleans(nlohmann::json::array(), 2) == nlohmann::json::parse("[false, false]"));
+    REQUIRE_THROWS(ResponseParser::IdsToBooleans(nlohmann::json::object(), 2));
+}
+
+TEST_CASE("Answers are matched to their tuples by id", "[response_parser]") {
+    // Out of order, one duplicate, one unknown id and one tuple left out
+    const auto answers = nlohmann::json::parse(R"([
+        {"id": 2, "response": "c"},
+        {"id": "0", "response": "a"},
+        {"id": 0, "response": "again"},
+        {"id": 9, "response": "unknown"}
+    ])");
+    const auto matches = ResponseParser::MatchAnswers(answers, 4, true);
+    REQUIRE(matches.size() == 4);
+    REQUIRE(matches[0].answer == 1);
+    REQUIRE(matches[0].value == 1);
+    REQUIRE(matches[1].answer == -1);
+    REQUIRE(matches[2].answer == 0);
+    REQUIRE(matches[2].value == 0);
+    // The tuples without an answer are the ones requested again
+    REQUIRE(matches[3].answer == -1);
+}
+
+TEST_CASE("Answers without ids are only taken in order when every tuple is answered", "[response_parser]") {
+    const auto answers = nlohmann::json::parse(R"([{"response": "a"}, {"response": "b"}])");
+    const auto matches = ResponseParser::MatchAnswers(answers, 2, true);
+    REQUIRE(matches[0].answer == 0);
+    REQUIRE(matches[1].answer == 1);
+    REQUIRE(matches[1].value == 1);
+
+    // A missing answer could belong to any tuple
+    for (const auto& match : ResponseParser::MatchAnswers(answers, 3, true)) {
+        REQUIRE(match.answer == -1);
+    }
+    // So could the answers of a truncated completion
+    for (const auto& match : ResponseParser::MatchAnswers(answers, 2, false)) {
+        REQUIRE(match.answer == -1);
+    }
+}
+
+TEST_CASE("Value indexes skip the answers without a response", "[response_parser]") {
+    const auto answers =
+        nlohmann::json::parse(R"([{"id": 0}, {"id": 1, "response": false}, {"id": 0, "response": true}])");
+    const auto matches = ResponseParser::MatchAnswers(answers, 2, true);
+    REQUIRE(matches[0].answer == 2);
+    REQUIRE(matches[0].value == 1);
+    REQUIRE(matches[1].answer == 1);
+    REQUIRE(matches[1].value == 0);
+}
@@ -0,0 +1,58 @@
+#include "catch.hpp"
+#include "flockmtl/prompt_manager/tuple_serializer.hpp"
+
+using flockmtl::TupleFormat;
+using flockmtl::TupleSerializer;
+
+namespace {
+
+nlohmann::json Tuples(const char* json) { return nlohmann::json::parse(json); }
+
+} // namespace
+
+TEST_CASE("Every format can be named and parsed back", "[tuple_serializer]") {
+    for (const auto* name : {"markdown", "compact_markdown", "csv", "tsv", "jsonl", "columnar"}) {
+        REQUIRE(TupleSerializer::FormatName(TupleSerializer::ParseFormat(name)) == name);
+    }
+    REQUIRE_THROWS(TupleSerializer::ParseFormat("xml"));
+}
+
+TEST_CASE("Tuples are serialized in each format", "[tuple_serializer]") {
+    // Columns come in the order of the JSON objects, sorted by name
+    const auto tuples = Tuples(R"([{"n": 1, "name": "a, b"}, {"n": 2, "name": "c|d"}])");
+    REQUIRE(TupleSerializer::Serialize(tuples, TupleFormat::CSV) == "n,name\n1,\"a, b\"\n2,c|d\n");
+    REQUIRE(TupleSerializer::Serialize(tuples, TupleFormat::TSV) == "n\tname\n1\ta, b\n2\tc|d\n");
+    REQUIRE(TupleSerializer::Serialize(tuples, TupleFormat::COMPACT_MARKDOWN) == "n|name\n-|-\n1|a, b\n2|c\\|d\n");
+    REQUIRE(TupleSerializer::Serialize(tuples, TupleFormat::JSONL) ==
+            "{\"n\":1,\"name\":\"a, b\"}\n{\"n\":2,\"name\":\"c|d\"}\n");
+    REQUIRE(TupleSerializer::Serialize(tuples, TupleFormat::COLUMNAR) == "n: 1|2\nname: a, b|c\\|d\n");
+    REQUIRE(TupleSerializer::Serialize(nlohmann::json::array(), TupleFormat::CSV).empty());
+}
+
+TEST_CASE("Columns constant across the batch are written once", "[tuple_serializer]") {
+    const auto tuples = Tuples(R"([{"lang": "en", "text": "x"}, {"lang": "en", "text": "y"}])");
+    REQUIRE(TupleSerializer::Serialize(tuples, TupleFormat::CSV) ==
+            "Same value in every tuple:\n- lang: en\n\ntext\nx\ny\n");
+    // A single tuple has nothing to share
+    REQUIRE(TupleSerializer::Serialize(Tuples(R"([{"lang": "en"}])"), TupleFormat::CSV) == "lang\nen\n");
+}
+
+TEST_CASE("Repeated long strings are aliased", "[tuple_serializer]") {
+    const std::string text(TupleSerializer::min_alias_length, 'x');
+    nlohmann::json tuples = nlohmann::json::array();
+    tuples.push_back({{"id", 0}, {"text", text}});
+    tuples.push_back({{"id", 1}, {"text", text}});
+    tuples.push_back({{"id", 2}, {"text", "short"}});
+    REQUIRE(TupleSerializer::Serialize(tuples, TupleFormat::CSV) ==
+            "Aliases used in the tuples:\n- @1: " + text + "\n\nid,text\n0,@1\n1,@1\n2,short\n");
+}
+
+TEST_CASE("Aliases never collide with literal values", "[tuple_serializer]") {
+    const std::string text(TupleSerializer::min_alias_length, 'x');
+    nlohmann::json tuples = nlohmann::json::array();
+    tuples.push_back({{"id", 0}, {"text", text}});
+    tuples.push_back({{"id", 1}, {"text", text}});
+    tuples.push_back({{"id", 2}, {"text", "@1"}});
+    REQUIRE(TupleSerializer::Serialize(tuples, TupleFormat::CSV) ==
+            "Aliases used in the tuples:\n- @@1: " + text + "\n\nid,text\n0,@@1\n1,@@1\n2,@1\n");
+}